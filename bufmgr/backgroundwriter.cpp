@@ -0,0 +1,79 @@
+#include <time.h>
+
+#include "../include/minirel.h"
+#include "../include/db.h"
+#include "../include/bufmgr.h"
+#include "../include/backgroundwriter.h"
+
+
+BackgroundWriter::BackgroundWriter(int interval)
+	: interval(interval), stop(false)
+{
+	numOfFrames = MINIBASE_BM->GetNumOfBuffers() / 4;
+	if (numOfFrames < 1)
+	{
+		numOfFrames = 1;
+	}
+
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&stopped, NULL);
+
+	started = (0 == pthread_create(&thread, NULL, Run, this));
+}
+
+
+BackgroundWriter::~BackgroundWriter()
+{
+	if (started)
+	{
+		pthread_mutex_lock(&lock);
+		stop = true;
+		pthread_cond_signal(&stopped);
+		pthread_mutex_unlock(&lock);
+
+		pthread_join(thread, NULL);
+	}
+
+	pthread_cond_destroy(&stopped);
+	pthread_mutex_destroy(&lock);
+}
+
+
+//---------------------------------------------------------------
+// BackgroundWriter::Run
+//
+// Purpose : The thread of a BackgroundWriter: clean ahead of the
+//           replacer every interval, until the BackgroundWriter is
+//           deleted.
+//---------------------------------------------------------------
+
+void* BackgroundWriter::Run(void* backgroundWriter)
+{
+	BackgroundWriter* self = (BackgroundWriter*)backgroundWriter;
+
+	pthread_mutex_lock(&self->lock);
+	while (!self->stop)
+	{
+		struct timespec wakeUp;
+		clock_gettime(CLOCK_REALTIME, &wakeUp);
+		wakeUp.tv_sec += self->interval / 1000;
+		wakeUp.tv_nsec += (long)(self->interval % 1000) * 1000000;
+		if (wakeUp.tv_nsec >= 1000000000)
+		{
+			wakeUp.tv_sec++;
+			wakeUp.tv_nsec -= 1000000000;
+		}
+
+		if (0 == pthread_cond_timedwait(&self->stopped, &self->lock, &wakeUp) || self->stop)
+		{
+			continue;
+		}
+
+		pthread_mutex_unlock(&self->lock);
+		MINIBASE_BM->CleanAhead(self->numOfFrames);
+		pthread_mutex_lock(&self->lock);
+	}
+	pthread_mutex_unlock(&self->lock);
+
+	return NULL;
+}
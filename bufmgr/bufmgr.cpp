@@ -0,0 +1,838 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "../include/minirel.h"
+#include "../include/db.h"
+#include "../include/bufmgr.h"
+#include "../include/readahead.h"
+
+
+// Most pages with consecutive IDs written by one call
+#define MAX_WRITE_RUN 16
+
+
+// Descriptor of the database file shared by the writes of WriteFrames
+// and the reads of the ReadAheadThread. It is opened on first use, as the
+// buffer manager is created before the database, and closed with the
+// buffer manager. Only pread and pwritev go through it, which leave
+// the file position alone.
+static int dbFile = -1;
+static pthread_mutex_t dbFileLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Unpinned frames of the pool, kept up to date by the frames as their
+// pin counts leave and return to 0
+static int numOfUnpinnedFrames = 0;
+
+// Reads the pages of PrefetchPage
+static ReadAheadThread* readAheadThread = NULL;
+
+
+// The fields of BufMgr as the prebuilt system library lays them out
+struct PrebuiltBufMgr
+{
+	HashTable *hashTable;
+	Frame **frames;
+	Replacer *replacer;
+	int numOfBuf;
+	long totalCall;
+	long totalHit;
+	long numDirtyPageWrites;
+};
+
+static_assert(sizeof(BufMgr) == sizeof(PrebuiltBufMgr), "the prebuilt system library allocates BufMgr with its original layout");
+
+
+BufferRing::BufferRing(int size) : size(size), next(0)
+{
+	frameNos = new int[size];
+	pids = new PageID[size];
+	for (int i = 0; i < size; i++)
+	{
+		frameNos[i] = INVALID_FRAME;
+		pids[i] = INVALID_PAGE;
+	}
+}
+
+
+BufferRing::~BufferRing()
+{
+	delete[] frameNos;
+	delete[] pids;
+}
+
+
+BufMgr::BufMgr(int bufsize) : numOfBuf(bufsize), totalCall(0), totalHit(0), numDirtyPageWrites(0)
+{
+	numOfUnpinnedFrames = numOfBuf;
+
+	frames = new Frame*[numOfBuf];
+	for (int i = 0; i < numOfBuf; i++)
+	{
+		frames[i] = new Frame(&numOfUnpinnedFrames);
+	}
+
+	// Every queued read holds a frame pinned
+	readAheadThread = new ReadAheadThread(numOfBuf);
+
+	hashTable = new HashTable(numOfBuf);
+	replacer = new Clock(numOfBuf, frames, hashTable);
+}
+
+
+BufMgr::~BufMgr()
+{
+	delete readAheadThread;
+	readAheadThread = NULL;
+	FlushAllPages();
+
+	if (-1 != dbFile)
+	{
+		close(dbFile);
+		dbFile = -1;
+	}
+
+	delete replacer;
+	delete hashTable;
+	for (int i = 0; i < numOfBuf; i++)
+	{
+		delete frames[i];
+	}
+	delete[] frames;
+}
+
+
+int BufMgr::FindFrame(PageID pid)
+{
+	hashTable->Lock(pid);
+	int frameNo = hashTable->LookUp(pid);
+	hashTable->Unlock(pid);
+
+	return frameNo;
+}
+
+
+// Pin the page if it is in the pool. It is pinned under the latch
+// of its partition, so it cannot be replaced in between.
+int BufMgr::PinFrame(PageID pid)
+{
+	hashTable->Lock(pid);
+	int frameNo = hashTable->LookUp(pid);
+	if (INVALID_FRAME != frameNo)
+	{
+		frames[frameNo]->Pin();
+	}
+	hashTable->Unlock(pid);
+
+	return frameNo;
+}
+
+
+//---------------------------------------------------------------
+// BufMgr::PickFrame
+//
+// Purpose : Choose a frame to read a missing page into: the frame
+//           of the ring's next slot if it still holds the page the
+//           ring read into it and nobody has that page pinned, else
+//           the victim of the replacement policy.
+//           Frames that only the buffer manager has pinned, while
+//           other threads write or replace their pages, are free
+//           again in a moment, so they are waited for; the writes
+//           do not wait for the DB lock, which the caller may hold,
+//           unless the database file cannot be opened (see
+//           Frame::Write), and then nothing is waited for.
+// Return  : The frame number, pinned for replacement, or
+//           INVALID_FRAME if users of the pages pin every frame.
+//---------------------------------------------------------------
+
+int BufMgr::PickFrame(BufferRing* ring)
+{
+	int frameNo = INVALID_FRAME;
+	if (NULL != ring)
+	{
+		frameNo = ring->frameNos[ring->next];
+		if (INVALID_FRAME != frameNo && !(frames[frameNo]->HasPageID(ring->pids[ring->next]) && frames[frameNo]->PinForReplacement()))
+		{
+			frameNo = INVALID_FRAME;
+		}
+	}
+
+	while (INVALID_FRAME == frameNo)
+	{
+		frameNo = replacer->PickVictim();
+		if (INVALID_FRAME != frameNo)
+		{
+			break;
+		}
+
+		int i = 0;
+		while (i < numOfBuf && frames[i]->IsPinnedByUsers())
+		{
+			i++;
+		}
+		if (i == numOfBuf || -1 == GetDBFile())
+		{
+			break;
+		}
+		sched_yield();
+	}
+
+	return frameNo;
+}
+
+
+//---------------------------------------------------------------
+// BufMgr::PlacePage
+//
+// Purpose : Give a missing page a frame (see PickFrame), writing
+//           out a dirty page in it first, and enter the page into
+//           the page table, the replacer and the ring. The frame is
+//           marked as being read (Frame::StartRead) for the caller,
+//           who reads the page into it and calls EndRead. Should
+//           another thread pin the old page while it is written,
+//           the frame is handed back and another one picked.
+// Input   : prefetch - TRUE for a read by a ReadAhead.
+// Output  : frameNo  - the frame, pinned once for the caller.
+// Return  : OK, DONE if another thread placed the page in the
+//           meantime, or FAIL if every frame is pinned or the old
+//           page cannot be written.
+//---------------------------------------------------------------
+
+Status BufMgr::PlacePage(PageID pid, BufferRing* ring, Bool prefetch, int& frameNo)
+{
+	while (true)
+	{
+		frameNo = PickFrame(ring);
+		if (INVALID_FRAME == frameNo)
+		{
+			return FAIL;
+		}
+
+		Frame *frame = frames[frameNo];
+		PageID oldPid = frame->GetPageID();
+		if (INVALID_PAGE != oldPid && frame->CleanIt())
+		{
+			if (OK != frame->Write())
+			{
+				// Keep the page, and let the replacer track it again
+				frame->DirtyIt();
+				frame->UnpinForReplacement();
+				replacer->ReturnFrame(frameNo);
+				return FAIL;
+			}
+			__atomic_add_fetch(&numDirtyPageWrites, 1, __ATOMIC_RELAXED);
+		}
+
+		hashTable->Lock(oldPid, pid);
+
+		if (INVALID_FRAME != hashTable->LookUp(pid))
+		{
+			hashTable->Unlock(oldPid, pid);
+			frame->UnpinForReplacement();
+			replacer->ReturnFrame(frameNo);
+			return DONE;
+		}
+
+		// Pinned again, or dirtied, while the old page was written
+		if (!frame->IsPinnedOnlyForReplacement() || frame->IsDirty())
+		{
+			hashTable->Unlock(oldPid, pid);
+			frame->UnpinForReplacement();
+			replacer->ReturnFrame(frameNo);
+			continue;
+		}
+
+		if (INVALID_PAGE != oldPid)
+		{
+			hashTable->Delete(oldPid);
+		}
+		frame->StartRead(pid, prefetch);
+		hashTable->Insert(pid, frameNo);
+		replacer->LoadFrame(frameNo);
+
+		hashTable->Unlock(oldPid, pid);
+
+		if (NULL != ring)
+		{
+			ring->frameNos[ring->next] = frameNo;
+			ring->pids[ring->next] = pid;
+			ring->next = (ring->next + 1) % ring->size;
+		}
+
+		return OK;
+	}
+}
+
+
+//---------------------------------------------------------------
+// BufMgr::PinPage
+//
+// Purpose : Pin the page, reading it into a frame chosen by the
+//           replacer unless it is in the pool already. A dirty
+//           page in that frame is written out first.
+// Input   : emptyPage - TRUE if the page is new and need not be
+//                       read from disk.
+//           ring      - the BufferRing of a sequential scan, which
+//                       provides the frame if the page is missing,
+//                       or NULL.
+// Return  : OK, or FAIL if every frame is pinned or the page cannot
+//           be read.
+//---------------------------------------------------------------
+
+Status BufMgr::PinPage(PageID pid, Page*& page, Bool emptyPage)
+{
+	return PinPage(pid, page, emptyPage, NULL);
+}
+
+
+Status BufMgr::PinPage(PageID pid, Page*& page, Bool emptyPage, BufferRing* ring)
+{
+	__atomic_add_fetch(&totalCall, 1, __ATOMIC_RELAXED);
+
+	while (true)
+	{
+		int frameNo = PinFrame(pid);
+		if (INVALID_FRAME != frameNo)
+		{
+			// Read ahead counts as a miss; the read may still be going
+			// on, as may the read by another thread that placed it
+			Frame *frame = frames[frameNo];
+			if (!frame->ClaimPrefetch())
+			{
+				__atomic_add_fetch(&totalHit, 1, __ATOMIC_RELAXED);
+			}
+			if (OK != frame->WaitForRead())
+			{
+				frame->Unpin();
+				return FAIL;
+			}
+
+			replacer->AccessFrame(frameNo);
+			page = frame->GetPage();
+			return OK;
+		}
+
+		Status status = PlacePage(pid, ring, FALSE, frameNo);
+		if (DONE == status)
+		{
+			continue;
+		}
+		if (OK != status)
+		{
+			return FAIL;
+		}
+
+		// A failed read leaves the page to be read again by the next
+		// thread that pins it
+		Frame *frame = frames[frameNo];
+		status = emptyPage ? OK : frame->Read(pid);
+		frame->EndRead(status);
+		if (OK != status)
+		{
+			frame->Unpin();
+			return FAIL;
+		}
+
+		page = frame->GetPage();
+		return OK;
+	}
+}
+
+
+//---------------------------------------------------------------
+// BufMgr::PrefetchPage
+//
+// Purpose : Set a frame aside for a page and have the read-ahead
+//           thread read the page into it. The frame stays pinned
+//           for the read until the caller unpins it, which it does
+//           only after frame->WaitForRead; whoever pins the page in
+//           the meantime waits for the read to end. Prefetching
+//           stops while three quarters of the pool are pinned, to
+//           leave frames to the caller's own pins.
+// Input   : ring - as for PinPage.
+// Return  : OK, DONE if the page is in the pool already, or FAIL if
+//           no frame is taken for it or the database file cannot
+//           be opened for the read.
+//---------------------------------------------------------------
+
+Status BufMgr::PrefetchPage(PageID pid, Frame*& frame, BufferRing* ring)
+{
+	if (INVALID_FRAME != FindFrame(pid))
+	{
+		return DONE;
+	}
+
+	if (GetNumOfUnpinnedFrames() <= (unsigned int)numOfBuf / 4 || -1 == GetDBFile())
+	{
+		return FAIL;
+	}
+
+	int frameNo;
+	Status status = PlacePage(pid, ring, TRUE, frameNo);
+	if (OK == status)
+	{
+		frame = frames[frameNo];
+		readAheadThread->Submit(pid, frame);
+	}
+
+	return status;
+}
+
+
+Status BufMgr::UnpinPage(PageID pid, Bool dirty)
+{
+	hashTable->Lock(pid);
+
+	int frameNo = hashTable->LookUp(pid);
+	if (INVALID_FRAME == frameNo || frames[frameNo]->NotPinned())
+	{
+		hashTable->Unlock(pid);
+		return FAIL;
+	}
+
+	if (dirty)
+	{
+		frames[frameNo]->DirtyIt();
+	}
+	frames[frameNo]->Unpin();
+
+	hashTable->Unlock(pid);
+	return OK;
+}
+
+
+//---------------------------------------------------------------
+// BufMgr::NewPage
+//
+// Purpose : Allocate a run of howmany pages and pin the first.
+// Return  : OK, or FAIL if the pages cannot be allocated or the
+//           first cannot be pinned; nothing is allocated then.
+//---------------------------------------------------------------
+
+Status BufMgr::NewPage(PageID& pid, Page*& firstpage, int howmany)
+{
+	Frame::LockDB();
+	Status status = MINIBASE_DB->AllocatePage(pid, howmany);
+	Frame::UnlockDB();
+
+	if (OK != status)
+	{
+		return FAIL;
+	}
+
+	if (OK != PinPage(pid, firstpage, TRUE))
+	{
+		Frame::LockDB();
+		MINIBASE_DB->DeallocatePage(pid, howmany);
+		Frame::UnlockDB();
+		return FAIL;
+	}
+
+	return OK;
+}
+
+
+//---------------------------------------------------------------
+// BufMgr::FreePage
+//
+// Purpose : Deallocate the page, dropping it from the pool first.
+//           The caller may still hold its own pin on it. A page
+//           that is being written out or evicted is waited for. No
+//           latch is held while DB deallocates the page, as DB pins
+//           pages itself.
+// Return  : OK, or FAIL if anyone else has the page pinned or it
+//           cannot be deallocated.
+//---------------------------------------------------------------
+
+Status BufMgr::FreePage(PageID pid)
+{
+	int frameNo;
+	Bool pinned;
+	while (true)
+	{
+		hashTable->Lock(pid);
+
+		frameNo = hashTable->LookUp(pid);
+		if (INVALID_FRAME == frameNo)
+		{
+			hashTable->Unlock(pid);
+
+			Frame::LockDB();
+			Status status = MINIBASE_DB->DeallocatePage(pid);
+			Frame::UnlockDB();
+			return status;
+		}
+
+		// Pin it unless the caller does, so that no replacer takes it
+		pinned = frames[frameNo]->PinForReplacement();
+		if (pinned || !frames[frameNo]->IsPinnedByBufMgr())
+		{
+			break;
+		}
+
+		hashTable->Unlock(pid);
+		sched_yield();
+	}
+
+	Frame *frame = frames[frameNo];
+	if (!pinned && 1 < frame->GetPinCount())
+	{
+		hashTable->Unlock(pid);
+		return FAIL;
+	}
+
+	// Out of the page table, nobody else can find the frame
+	frame->CleanIt();
+	hashTable->Delete(pid);
+	hashTable->Unlock(pid);
+
+	frame->WaitForRead();
+	replacer->FreeFrame(frameNo);
+	frame->EmptyIt();
+
+	Frame::LockDB();
+	Status status = MINIBASE_DB->DeallocatePage(pid);
+	Frame::UnlockDB();
+
+	return status;
+}
+
+
+// A dirty page pinned for writing, sorted by page ID
+struct DirtyPage
+{
+	PageID pid;
+	int frameNo;
+};
+
+
+static int CompareDirtyPages(const void* a, const void* b)
+{
+	const DirtyPage* pageA = (const DirtyPage*)a;
+	const DirtyPage* pageB = (const DirtyPage*)b;
+
+	return (pageA->pid < pageB->pid) ? -1 : ((pageA->pid > pageB->pid) ? 1 : 0);
+}
+
+
+//---------------------------------------------------------------
+// BufMgr::WriteFrames
+//
+// Purpose : Write out the dirty pages in the given frames. The
+//           frames are pinned while their pages are written, so
+//           that they keep them, but the pins do not count as
+//           references. Pages with consecutive IDs are written
+//           together, up to MAX_WRITE_RUN at a time, with one
+//           pwritev to the database file, which stores page n at
+//           n * MINIBASE_PAGESIZE; single pages, and all pages if
+//           the file cannot be opened, are written through DB.
+// Input   : unpinnedOnly - TRUE to pass over pages someone has
+//                          pinned, which may be changing.
+// Output  : numOfWritten - the number of pages written.
+// Return  : OK, or FAIL if a page cannot be written; it stays
+//           dirty then.
+//---------------------------------------------------------------
+
+Status BufMgr::WriteFrames(const int* frameNos, int n, Bool unpinnedOnly, unsigned int& numOfWritten)
+{
+	numOfWritten = 0;
+
+	DirtyPage *pages = new DirtyPage[n];
+	int numOfPages = 0;
+	for (int i = 0; i < n; i++)
+	{
+		Frame *frame = frames[frameNos[i]];
+		PageID pid = frame->GetPageID();
+		if (INVALID_PAGE == pid || !frame->IsDirty())
+		{
+			continue;
+		}
+
+		// Unless it was replaced, and written then, in the meantime
+		hashTable->Lock(pid);
+		if (frameNos[i] == hashTable->LookUp(pid) && (!unpinnedOnly || frame->NotPinned()))
+		{
+			frame->PinForWrite();
+			pages[numOfPages].pid = pid;
+			pages[numOfPages].frameNo = frameNos[i];
+			numOfPages++;
+		}
+		hashTable->Unlock(pid);
+	}
+
+	qsort(pages, numOfPages, sizeof(DirtyPage), CompareDirtyPages);
+
+	int fd = (1 < numOfPages) ? GetDBFile() : -1;
+	int maxRun = (-1 == fd) ? 1 : MAX_WRITE_RUN;
+
+	Status status = OK;
+	for (int first = 0; first < numOfPages; )
+	{
+		int last = first + 1;
+		while (last < numOfPages && last - first < maxRun && pages[last].pid == pages[last - 1].pid + 1)
+		{
+			last++;
+		}
+
+		// Clear the dirty bits before the pages are written, so that
+		// changes made while they are written dirty them again
+		Bool cleaned[MAX_WRITE_RUN];
+		struct iovec iov[MAX_WRITE_RUN];
+		for (int i = first; i < last; i++)
+		{
+			Frame *frame = frames[pages[i].frameNo];
+			cleaned[i - first] = frame->CleanIt();
+			iov[i - first].iov_base = frame->GetPage();
+			iov[i - first].iov_len = MINIBASE_PAGESIZE;
+		}
+
+		Status runStatus;
+		if (1 < last - first)
+		{
+			ssize_t numOfBytes = pwritev(fd, iov, last - first, (off_t)pages[first].pid * MINIBASE_PAGESIZE);
+			runStatus = ((ssize_t)(last - first) * MINIBASE_PAGESIZE == numOfBytes) ? OK : FAIL;
+		}
+		else
+		{
+			runStatus = cleaned[0] ? frames[pages[first].frameNo]->Write() : OK;
+		}
+
+		for (int i = first; i < last; i++)
+		{
+			if (!cleaned[i - first])
+			{
+				continue;
+			}
+			if (OK == runStatus)
+			{
+				numOfWritten++;
+			}
+			else
+			{
+				frames[pages[i].frameNo]->DirtyIt();
+			}
+		}
+		if (OK != runStatus)
+		{
+			status = FAIL;
+		}
+
+		first = last;
+	}
+
+	for (int i = 0; i < numOfPages; i++)
+	{
+		frames[pages[i].frameNo]->UnpinForWrite();
+	}
+	delete[] pages;
+
+	__atomic_add_fetch(&numDirtyPageWrites, (long)numOfWritten, __ATOMIC_RELAXED);
+	return status;
+}
+
+
+Status BufMgr::FlushPage(PageID pid)
+{
+	int frameNo = FindFrame(pid);
+	if (INVALID_FRAME == frameNo)
+	{
+		return FAIL;
+	}
+
+	unsigned int numOfWritten;
+	return WriteFrames(&frameNo, 1, FALSE, numOfWritten);
+}
+
+
+Status BufMgr::FlushAllPages()
+{
+	int *frameNos = new int[numOfBuf];
+	for (int i = 0; i < numOfBuf; i++)
+	{
+		frameNos[i] = i;
+	}
+
+	unsigned int numOfWritten;
+	Status status = WriteFrames(frameNos, numOfBuf, FALSE, numOfWritten);
+
+	delete[] frameNos;
+	return status;
+}
+
+
+//---------------------------------------------------------------
+// BufMgr::GetDBFile
+//
+// Purpose : Open the database file for pread and pwritev, once per
+//           buffer manager.
+// Return  : The descriptor, or -1 if the file cannot be opened.
+//---------------------------------------------------------------
+
+int BufMgr::GetDBFile()
+{
+	int fd = __atomic_load_n(&dbFile, __ATOMIC_ACQUIRE);
+	if (-1 != fd)
+	{
+		return fd;
+	}
+
+	pthread_mutex_lock(&dbFileLock);
+	if (-1 == dbFile)
+	{
+		__atomic_store_n(&dbFile, open(MINIBASE_DB->GetName(), O_RDWR), __ATOMIC_RELEASE);
+	}
+	fd = dbFile;
+	pthread_mutex_unlock(&dbFileLock);
+
+	return fd;
+}
+
+
+//---------------------------------------------------------------
+// BufMgr::CleanAhead
+//
+// Purpose : Write out the dirty pages among the next numOfFrames
+//           victims of the replacer that nobody has pinned, so that
+//           the threads that evict them need not wait for the
+//           writes.
+// Return  : The number of pages written.
+//---------------------------------------------------------------
+
+unsigned int BufMgr::CleanAhead(int numOfFrames)
+{
+	int *frameNos = new int[numOfFrames];
+	int n = replacer->UpcomingVictims(frameNos, numOfFrames);
+
+	unsigned int numOfWritten;
+	WriteFrames(frameNos, n, TRUE, numOfWritten);
+
+	delete[] frameNos;
+	return numOfWritten;
+}
+
+
+//---------------------------------------------------------------
+// BufMgr::SetReplacementPolicy
+//
+// Purpose : Replace pages by the named policy from now on (see
+//           Replacer::Create). The pages in the pool are handed to
+//           the new replacer as if just read.
+// Return  : OK, or FAIL if there is no such policy.
+//---------------------------------------------------------------
+
+Status BufMgr::SetReplacementPolicy(const char* policy)
+{
+	Replacer *newReplacer = Replacer::Create(policy, numOfBuf, frames, hashTable);
+	if (NULL == newReplacer)
+	{
+		cerr << "ERROR: unknown replacement policy " << policy << ".\n";
+		return FAIL;
+	}
+
+	delete replacer;
+	replacer = newReplacer;
+
+	for (int i = 0; i < numOfBuf; i++)
+	{
+		if (frames[i]->IsValid())
+		{
+			replacer->LoadFrame(i);
+		}
+	}
+
+	return OK;
+}
+
+
+unsigned int BufMgr::GetNumOfUnpinnedFrames()
+{
+	return __atomic_load_n(&numOfUnpinnedFrames, __ATOMIC_RELAXED);
+}
+
+
+//---------------------------------------------------------------
+// BufMgr::CheckPool
+//
+// Purpose : Check the pool while no other thread uses it, for the
+//           tests: no frame is pinned, the count of unpinned frames
+//           agrees, no page is in two frames, and the page table
+//           maps every page in the pool, and nothing else, to its
+//           frame.
+// Return  : OK, or FAIL if any of this does not hold.
+//---------------------------------------------------------------
+
+Status BufMgr::CheckPool()
+{
+	Status status = OK;
+	int numOfPages = 0;
+	for (int i = 0; i < numOfBuf; i++)
+	{
+		if (!frames[i]->NotPinned())
+		{
+			cerr << "ERROR: frame " << i << " is pinned " << frames[i]->GetPinCount() << " times.\n";
+			status = FAIL;
+		}
+
+		PageID pid = frames[i]->GetPageID();
+		if (INVALID_PAGE == pid)
+		{
+			continue;
+		}
+		numOfPages++;
+
+		for (int j = 0; j < i; j++)
+		{
+			if (frames[j]->HasPageID(pid))
+			{
+				cerr << "ERROR: page " << pid << " is in frames " << j << " and " << i << ".\n";
+				status = FAIL;
+			}
+		}
+
+		if (i != hashTable->LookUp(pid))
+		{
+			cerr << "ERROR: page " << pid << " of frame " << i << " is under frame " << hashTable->LookUp(pid) << " in the page table.\n";
+			status = FAIL;
+		}
+	}
+
+	if (numOfPages != hashTable->GetNumOfPages())
+	{
+		cerr << "ERROR: the page table holds " << hashTable->GetNumOfPages() << " pages, the frames " << numOfPages << ".\n";
+		status = FAIL;
+	}
+
+	if (GetNumOfUnpinnedFrames() != (unsigned int)numOfBuf)
+	{
+		cerr << "ERROR: " << GetNumOfUnpinnedFrames() << " of " << numOfBuf << " frames are counted as unpinned.\n";
+		status = FAIL;
+	}
+
+	return status;
+}
+
+
+unsigned int BufMgr::GetNumOfBuffers()
+{
+	return numOfBuf;
+}
+
+
+unsigned int BufMgr::GetNumOfUnpinnedBuffers()
+{
+	return GetNumOfUnpinnedFrames();
+}
+
+
+void BufMgr::PrintStat()
+{
+	cout << "**Buffer Manager Statistics**\n"
+		<< "Number of Dirty Pages Written to Disk: " << numDirtyPageWrites << "\n"
+		<< "Number of Pin Page Requests: " << totalCall << "\n"
+		<< "Number of Pin Page Request Misses: " << totalCall - totalHit << "\n";
+}
@@ -0,0 +1,361 @@
+#include <unistd.h>
+
+#include "../include/minirel.h"
+#include "../include/db.h"
+#include "../include/bufmgr.h"
+#include "../include/frame.h"
+
+
+// Serialises the calls of all frames into DB, which keeps a file
+// position on its descriptor. DB pins the pages of its space map
+// through the buffer manager, so the lock is recursive.
+static pthread_mutex_t dbLock;
+static pthread_once_t dbLockOnce = PTHREAD_ONCE_INIT;
+
+
+static void InitDBLock()
+{
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&dbLock, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+
+Frame::Frame(int *numOfUnpinnedFrames) : pid(INVALID_PAGE), pinCount(0), dirty(FALSE), referenced(FALSE), reading(FALSE), readFailed(FALSE), prefetched(FALSE), numOfUnpinnedFrames(numOfUnpinnedFrames)
+{
+	data = new Page();
+	pthread_mutex_init(&ioLock, NULL);
+	pthread_cond_init(&ioDone, NULL);
+}
+
+
+Frame::~Frame()
+{
+	pthread_cond_destroy(&ioDone);
+	pthread_mutex_destroy(&ioLock);
+	delete data;
+}
+
+
+void Frame::CountPinned()
+{
+	__atomic_sub_fetch(numOfUnpinnedFrames, 1, __ATOMIC_RELAXED);
+}
+
+
+void Frame::CountUnpinned()
+{
+	__atomic_add_fetch(numOfUnpinnedFrames, 1, __ATOMIC_RELAXED);
+}
+
+
+void Frame::Pin()
+{
+	if (1 == __atomic_add_fetch(&pinCount, 1, __ATOMIC_ACQ_REL))
+	{
+		CountPinned();
+	}
+	__atomic_store_n(&referenced, TRUE, __ATOMIC_RELAXED);
+}
+
+
+// Keep the page in the frame while it is written out; not a reference
+void Frame::PinForWrite()
+{
+	if (WRITE_PIN == __atomic_add_fetch(&pinCount, WRITE_PIN, __ATOMIC_ACQ_REL))
+	{
+		CountPinned();
+	}
+}
+
+
+//---------------------------------------------------------------
+// Frame::PinForReplacement
+//
+// Purpose : Pin the frame for a replacer that picked it as victim,
+//           unless another thread pinned it in the meantime. The
+//           pin counts REPLACEMENT_PIN, so that others can tell it
+//           from the pins of users of the page.
+// Return  : TRUE if the caller holds the only pin now.
+//---------------------------------------------------------------
+
+Bool Frame::PinForReplacement()
+{
+	int expected = 0;
+	if (!__atomic_compare_exchange_n(&pinCount, &expected, REPLACEMENT_PIN, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+	{
+		return FALSE;
+	}
+
+	CountPinned();
+	return TRUE;
+}
+
+
+void Frame::Unpin()
+{
+	if (0 == __atomic_sub_fetch(&pinCount, 1, __ATOMIC_ACQ_REL))
+	{
+		CountUnpinned();
+	}
+}
+
+
+void Frame::UnpinForWrite()
+{
+	if (0 == __atomic_sub_fetch(&pinCount, WRITE_PIN, __ATOMIC_ACQ_REL))
+	{
+		CountUnpinned();
+	}
+}
+
+
+void Frame::UnpinForReplacement()
+{
+	if (0 == __atomic_sub_fetch(&pinCount, REPLACEMENT_PIN, __ATOMIC_ACQ_REL))
+	{
+		CountUnpinned();
+	}
+}
+
+
+Bool Frame::IsPinnedByBufMgr()
+{
+	return (GetPinCount() >= WRITE_PIN);
+}
+
+
+Bool Frame::IsPinnedByUsers()
+{
+	return (0 != GetPinCount() % WRITE_PIN);
+}
+
+
+Bool Frame::IsPinnedOnlyForReplacement()
+{
+	return (REPLACEMENT_PIN == GetPinCount());
+}
+
+
+int Frame::GetPinCount()
+{
+	return __atomic_load_n(&pinCount, __ATOMIC_ACQUIRE);
+}
+
+
+void Frame::EmptyIt()
+{
+	__atomic_store_n(&pid, INVALID_PAGE, __ATOMIC_RELAXED);
+	if (0 != __atomic_exchange_n(&pinCount, 0, __ATOMIC_ACQ_REL))
+	{
+		CountUnpinned();
+	}
+	__atomic_store_n(&dirty, FALSE, __ATOMIC_RELEASE);
+	__atomic_store_n(&referenced, FALSE, __ATOMIC_RELAXED);
+	__atomic_store_n(&readFailed, FALSE, __ATOMIC_RELEASE);
+	__atomic_store_n(&prefetched, FALSE, __ATOMIC_RELAXED);
+}
+
+
+void Frame::DirtyIt()
+{
+	__atomic_store_n(&dirty, TRUE, __ATOMIC_RELEASE);
+}
+
+
+// Clear the dirty bit before the page is written, so that changes
+// made while it is being written dirty it again
+Bool Frame::CleanIt()
+{
+	return __atomic_exchange_n(&dirty, FALSE, __ATOMIC_ACQ_REL);
+}
+
+
+void Frame::SetPageID(PageID pid)
+{
+	__atomic_store_n(&this->pid, pid, __ATOMIC_RELAXED);
+}
+
+
+Bool Frame::IsDirty()
+{
+	return __atomic_load_n(&dirty, __ATOMIC_ACQUIRE);
+}
+
+
+Bool Frame::IsValid()
+{
+	return (INVALID_PAGE != GetPageID());
+}
+
+
+// Written with pwrite to the buffer manager's descriptor of the
+// database file, which stores page n at n * MINIBASE_PAGESIZE, so
+// that a thread holding the frame for a write never waits for the
+// DB lock; through DB only if that file cannot be opened
+Status Frame::Write()
+{
+	int fd = MINIBASE_BM->GetDBFile();
+	if (-1 != fd)
+	{
+		ssize_t numOfBytes = pwrite(fd, data, MINIBASE_PAGESIZE, (off_t)GetPageID() * MINIBASE_PAGESIZE);
+		return (MINIBASE_PAGESIZE == numOfBytes) ? OK : FAIL;
+	}
+
+	LockDB();
+	Status status = MINIBASE_DB->WritePage(GetPageID(), data);
+	UnlockDB();
+
+	return (OK == status) ? OK : FAIL;
+}
+
+
+Status Frame::Read(PageID pid)
+{
+	LockDB();
+	Status status = MINIBASE_DB->ReadPage(pid, data);
+	UnlockDB();
+
+	return (OK == status) ? OK : FAIL;
+}
+
+
+Bool Frame::NotPinned()
+{
+	return (0 == GetPinCount());
+}
+
+
+Bool Frame::HasPageID(PageID pid)
+{
+	return (pid == GetPageID());
+}
+
+
+PageID Frame::GetPageID()
+{
+	return __atomic_load_n(&pid, __ATOMIC_RELAXED);
+}
+
+
+Page *Frame::GetPage()
+{
+	return data;
+}
+
+
+void Frame::UnsetReferenced()
+{
+	__atomic_store_n(&referenced, FALSE, __ATOMIC_RELAXED);
+}
+
+
+Bool Frame::IsReferenced()
+{
+	return __atomic_load_n(&referenced, __ATOMIC_RELAXED);
+}
+
+
+Bool Frame::IsVictim()
+{
+	return (!IsValid() || (NotPinned() && !IsReferenced()));
+}
+
+
+//---------------------------------------------------------------
+// Frame::StartRead
+//
+// Purpose : Mark the frame as holding pid, which the caller or
+//           another thread is about to read into it (prefetch TRUE
+//           for a ReadAhead). Until EndRead, the page must not be
+//           used; WaitForRead blocks until it may. The replacement
+//           pin of the caller becomes an ordinary one.
+//---------------------------------------------------------------
+
+void Frame::StartRead(PageID pid, Bool prefetch)
+{
+	pthread_mutex_lock(&ioLock);
+	__atomic_add_fetch(&pinCount, 1 - REPLACEMENT_PIN, __ATOMIC_ACQ_REL);
+	SetPageID(pid);
+	__atomic_store_n(&dirty, FALSE, __ATOMIC_RELEASE);
+	__atomic_store_n(&referenced, TRUE, __ATOMIC_RELAXED);
+	__atomic_store_n(&reading, TRUE, __ATOMIC_RELEASE);
+	__atomic_store_n(&readFailed, FALSE, __ATOMIC_RELEASE);
+	__atomic_store_n(&prefetched, prefetch, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&ioLock);
+}
+
+
+void Frame::EndRead(Status status)
+{
+	pthread_mutex_lock(&ioLock);
+	__atomic_store_n(&readFailed, (OK != status) ? TRUE : FALSE, __ATOMIC_RELEASE);
+	__atomic_store_n(&reading, FALSE, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&ioDone);
+	pthread_mutex_unlock(&ioLock);
+}
+
+
+//---------------------------------------------------------------
+// Frame::WaitForRead
+//
+// Purpose : Wait until the page has been read into the frame. If
+//           the read failed, read it again; threads that wait at
+//           the same time wait for that read instead of starting
+//           their own.
+// Return  : OK, or FAIL if the page could not be read.
+//---------------------------------------------------------------
+
+Status Frame::WaitForRead()
+{
+	if (!__atomic_load_n(&reading, __ATOMIC_ACQUIRE) && !__atomic_load_n(&readFailed, __ATOMIC_ACQUIRE))
+	{
+		return OK;
+	}
+
+	pthread_mutex_lock(&ioLock);
+	while (reading)
+	{
+		pthread_cond_wait(&ioDone, &ioLock);
+	}
+
+	if (readFailed)
+	{
+		__atomic_store_n(&reading, TRUE, __ATOMIC_RELEASE);
+		pthread_mutex_unlock(&ioLock);
+
+		EndRead(Read(GetPageID()));
+
+		pthread_mutex_lock(&ioLock);
+	}
+
+	Status status = readFailed ? FAIL : OK;
+	pthread_mutex_unlock(&ioLock);
+
+	return status;
+}
+
+
+Bool Frame::ClaimPrefetch()
+{
+	if (!__atomic_load_n(&prefetched, __ATOMIC_RELAXED))
+	{
+		return FALSE;
+	}
+	return __atomic_exchange_n(&prefetched, FALSE, __ATOMIC_RELAXED);
+}
+
+
+void Frame::LockDB()
+{
+	pthread_once(&dbLockOnce, InitDBLock);
+	pthread_mutex_lock(&dbLock);
+}
+
+
+void Frame::UnlockDB()
+{
+	pthread_mutex_unlock(&dbLock);
+}
@@ -0,0 +1,265 @@
+#include "../include/minirel.h"
+#include "../include/hash.h"
+
+
+// Fewest entries of a partition
+#define MIN_NUM_OF_ENTRIES 16
+
+// 2^32 / golden ratio: spreads consecutive page IDs over the table
+#define FIBONACCI_MULTIPLIER 2654435769u
+
+
+HashTable::HashTable(int numOfBuf)
+{
+	int size = MIN_NUM_OF_ENTRIES;
+	while (size < 2 * numOfBuf / NUM_OF_PARTITIONS)
+	{
+		size *= 2;
+	}
+
+	for (int i = 0; i < NUM_OF_PARTITIONS; i++)
+	{
+		Partition &partition = partitions[i];
+		partition.entries = NULL;
+		partition.numOfEntries = 0;
+		partition.numOfPages = 0;
+		partition.shift = 0;
+		pthread_mutex_init(&partition.latch, NULL);
+
+		Resize(partition, size);
+	}
+}
+
+
+HashTable::~HashTable()
+{
+	for (int i = 0; i < NUM_OF_PARTITIONS; i++)
+	{
+		pthread_mutex_destroy(&partitions[i].latch);
+		delete[] partitions[i].entries;
+	}
+}
+
+
+// Consecutive page IDs go to different partitions
+int HashTable::PartitionOf(PageID pid)
+{
+	return (int)((unsigned int)pid % NUM_OF_PARTITIONS);
+}
+
+
+int HashTable::Home(Partition &partition, PageID pid)
+{
+	return (int)(((unsigned int)pid * FIBONACCI_MULTIPLIER) >> partition.shift);
+}
+
+
+//---------------------------------------------------------------
+// HashTable::Resize
+//
+// Purpose : Move the pages of the partition to an array of
+//           newNumOfEntries entries, a power of two.
+//---------------------------------------------------------------
+
+void HashTable::Resize(Partition &partition, int newNumOfEntries)
+{
+	Entry *oldEntries = partition.entries;
+	int oldNumOfEntries = partition.numOfEntries;
+
+	partition.entries = new Entry[newNumOfEntries];
+	partition.numOfEntries = newNumOfEntries;
+	partition.numOfPages = 0;
+
+	partition.shift = 32;
+	for (int size = 1; size < newNumOfEntries; size *= 2)
+	{
+		partition.shift--;
+	}
+
+	for (int i = 0; i < partition.numOfEntries; i++)
+	{
+		partition.entries[i].pid = INVALID_PAGE;
+	}
+
+	for (int i = 0; i < oldNumOfEntries; i++)
+	{
+		if (INVALID_PAGE != oldEntries[i].pid)
+		{
+			Insert(partition, oldEntries[i].pid, oldEntries[i].frameNo);
+		}
+	}
+
+	delete[] oldEntries;
+}
+
+
+void HashTable::Insert(Partition &partition, PageID pid, int frameNo)
+{
+	if (2 * (partition.numOfPages + 1) > partition.numOfEntries)
+	{
+		Resize(partition, 2 * partition.numOfEntries);
+	}
+
+	Entry *entries = partition.entries;
+	int i = Home(partition, pid);
+	while (INVALID_PAGE != entries[i].pid && pid != entries[i].pid)
+	{
+		i = (i + 1) & (partition.numOfEntries - 1);
+	}
+
+	if (INVALID_PAGE == entries[i].pid)
+	{
+		partition.numOfPages++;
+	}
+	entries[i].pid = pid;
+	entries[i].frameNo = frameNo;
+}
+
+
+void HashTable::Insert(PageID pid, int frameNo)
+{
+	Insert(partitions[PartitionOf(pid)], pid, frameNo);
+}
+
+
+//---------------------------------------------------------------
+// HashTable::Delete
+//
+// Purpose : Remove the page from the table. Every later entry of
+//           the probe sequence that could be stored in the freed
+//           entry is moved back into it, and the entry it left
+//           is filled the same way, until a free entry ends the
+//           sequence.
+// Return  : OK, or FAIL if the page is not in the table.
+//---------------------------------------------------------------
+
+Status HashTable::Delete(PageID pid)
+{
+	Partition &partition = partitions[PartitionOf(pid)];
+	Entry *entries = partition.entries;
+	int mask = partition.numOfEntries - 1;
+
+	int hole = Home(partition, pid);
+	while (pid != entries[hole].pid)
+	{
+		if (INVALID_PAGE == entries[hole].pid)
+		{
+			return FAIL;
+		}
+		hole = (hole + 1) & mask;
+	}
+
+	for (int i = (hole + 1) & mask; INVALID_PAGE != entries[i].pid; i = (i + 1) & mask)
+	{
+		// An entry can move back into the hole unless its home lies
+		// after the hole, i.e. between the hole and the entry
+		int home = Home(partition, entries[i].pid);
+		bool stays = (hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i);
+		if (!stays)
+		{
+			entries[hole] = entries[i];
+			hole = i;
+		}
+	}
+
+	entries[hole].pid = INVALID_PAGE;
+	partition.numOfPages--;
+
+	return OK;
+}
+
+
+int HashTable::LookUp(PageID pid)
+{
+	Partition &partition = partitions[PartitionOf(pid)];
+	Entry *entries = partition.entries;
+
+	int i = Home(partition, pid);
+	while (INVALID_PAGE != entries[i].pid)
+	{
+		if (pid == entries[i].pid)
+		{
+			return entries[i].frameNo;
+		}
+		i = (i + 1) & (partition.numOfEntries - 1);
+	}
+
+	return INVALID_FRAME;
+}
+
+
+void HashTable::EmptyIt()
+{
+	for (int p = 0; p < NUM_OF_PARTITIONS; p++)
+	{
+		Partition &partition = partitions[p];
+		for (int i = 0; i < partition.numOfEntries; i++)
+		{
+			partition.entries[i].pid = INVALID_PAGE;
+		}
+		partition.numOfPages = 0;
+	}
+}
+
+
+int HashTable::GetNumOfPages()
+{
+	int numOfPages = 0;
+	for (int p = 0; p < NUM_OF_PARTITIONS; p++)
+	{
+		numOfPages += partitions[p].numOfPages;
+	}
+
+	return numOfPages;
+}
+
+
+void HashTable::Lock(PageID pid)
+{
+	if (INVALID_PAGE != pid)
+	{
+		pthread_mutex_lock(&partitions[PartitionOf(pid)].latch);
+	}
+}
+
+
+void HashTable::Unlock(PageID pid)
+{
+	if (INVALID_PAGE != pid)
+	{
+		pthread_mutex_unlock(&partitions[PartitionOf(pid)].latch);
+	}
+}
+
+
+void HashTable::Lock(PageID pid1, PageID pid2)
+{
+	if (INVALID_PAGE == pid1 || INVALID_PAGE == pid2 || PartitionOf(pid1) == PartitionOf(pid2))
+	{
+		Lock((INVALID_PAGE == pid1) ? pid2 : pid1);
+		return;
+	}
+
+	// Lower partition first, so two threads never wait for each other
+	if (PartitionOf(pid1) > PartitionOf(pid2))
+	{
+		PageID pid = pid1;
+		pid1 = pid2;
+		pid2 = pid;
+	}
+	Lock(pid1);
+	Lock(pid2);
+}
+
+
+void HashTable::Unlock(PageID pid1, PageID pid2)
+{
+	if (INVALID_PAGE == pid1 || INVALID_PAGE == pid2 || PartitionOf(pid1) == PartitionOf(pid2))
+	{
+		Unlock((INVALID_PAGE == pid1) ? pid2 : pid1);
+		return;
+	}
+
+	Unlock(pid1);
+	Unlock(pid2);
+}
@@ -0,0 +1,162 @@
+#include <unistd.h>
+
+#include "../include/minirel.h"
+#include "../include/db.h"
+#include "../include/bufmgr.h"
+#include "../include/readahead.h"
+
+
+ReadAhead::ReadAhead(int depth, BufferRing* ring)
+	: depth(depth), ring(ring), numOfIssued(0), numOfReleased(0)
+{
+	pids = new PageID[depth];
+	frames = new Frame*[depth];
+}
+
+
+ReadAhead::~ReadAhead()
+{
+	// A frame is only handed back once the read into it has ended
+	while (numOfReleased < numOfIssued)
+	{
+		frames[numOfReleased % depth]->WaitForRead();
+		MINIBASE_BM->UnpinPage(pids[numOfReleased++ % depth], FALSE);
+	}
+
+	delete[] pids;
+	delete[] frames;
+}
+
+
+void ReadAhead::Issue(PageID pid)
+{
+	if (numOfIssued - numOfReleased == depth)
+	{
+		return;
+	}
+
+	Frame* frame;
+	if (OK != MINIBASE_BM->PrefetchPage(pid, frame, ring))
+	{
+		return;
+	}
+
+	pids[numOfIssued % depth] = pid;
+	frames[numOfIssued % depth] = frame;
+	numOfIssued++;
+}
+
+
+void ReadAhead::Release(PageID pid)
+{
+	if (numOfReleased < numOfIssued && pid == pids[numOfReleased % depth])
+	{
+		MINIBASE_BM->UnpinPage(pid, FALSE);
+		numOfReleased++;
+	}
+}
+
+
+ReadAheadThread::ReadAheadThread(int capacity)
+	: capacity(capacity), numOfSubmitted(0), numOfRead(0), started(false), stop(false)
+{
+	pids = new PageID[capacity];
+	frames = new Frame*[capacity];
+
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&submitted, NULL);
+}
+
+
+ReadAheadThread::~ReadAheadThread()
+{
+	// Let the thread finish the queued reads
+	if (started)
+	{
+		pthread_mutex_lock(&lock);
+		stop = true;
+		pthread_cond_signal(&submitted);
+		pthread_mutex_unlock(&lock);
+
+		pthread_join(thread, NULL);
+	}
+
+	pthread_cond_destroy(&submitted);
+	pthread_mutex_destroy(&lock);
+
+	delete[] pids;
+	delete[] frames;
+}
+
+
+Status ReadAheadThread::Read(PageID pid, Frame* frame)
+{
+	ssize_t numOfBytes = pread(MINIBASE_BM->GetDBFile(), frame->GetPage(), MINIBASE_PAGESIZE, (off_t)pid * MINIBASE_PAGESIZE);
+	return (MINIBASE_PAGESIZE == numOfBytes) ? OK : FAIL;
+}
+
+
+void ReadAheadThread::Submit(PageID pid, Frame* frame)
+{
+	pthread_mutex_lock(&lock);
+
+	if (!started)
+	{
+		started = (0 == pthread_create(&thread, NULL, Run, this));
+	}
+
+	if (!started || numOfSubmitted - numOfRead == capacity)
+	{
+		// Read it here, then
+		pthread_mutex_unlock(&lock);
+		frame->EndRead(Read(pid, frame));
+		return;
+	}
+
+	pids[numOfSubmitted % capacity] = pid;
+	frames[numOfSubmitted % capacity] = frame;
+	numOfSubmitted++;
+	pthread_cond_signal(&submitted);
+
+	pthread_mutex_unlock(&lock);
+}
+
+
+//---------------------------------------------------------------
+// ReadAheadThread::Run
+//
+// Purpose : The read-ahead thread: read the submitted pages in
+//           order into their frames, until the ReadAheadThread is
+//           deleted and no read is queued.
+//---------------------------------------------------------------
+
+void* ReadAheadThread::Run(void* readAheadThread)
+{
+	ReadAheadThread* self = (ReadAheadThread*)readAheadThread;
+
+	pthread_mutex_lock(&self->lock);
+	while (true)
+	{
+		if (self->numOfRead == self->numOfSubmitted)
+		{
+			if (self->stop)
+			{
+				break;
+			}
+			pthread_cond_wait(&self->submitted, &self->lock);
+			continue;
+		}
+
+		PageID pid = self->pids[self->numOfRead % self->capacity];
+		Frame* frame = self->frames[self->numOfRead % self->capacity];
+		pthread_mutex_unlock(&self->lock);
+
+		frame->EndRead(Read(pid, frame));
+
+		pthread_mutex_lock(&self->lock);
+		self->numOfRead++;
+	}
+	pthread_mutex_unlock(&self->lock);
+
+	return NULL;
+}
@@ -0,0 +1,1029 @@
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+
+#include "../include/minirel.h"
+#include "../include/replacer.h"
+
+
+// References LRU-K keeps per page unless the policy names another K
+#define DEFAULT_LRU_K 2
+#define MAX_LRU_K 8
+
+
+Replacer::Replacer()
+{
+	pthread_mutex_init(&latch, NULL);
+}
+
+
+Replacer::~Replacer()
+{
+	pthread_mutex_destroy(&latch);
+}
+
+
+void Replacer::AccessFrame(int)
+{
+}
+
+
+void Replacer::LoadFrame(int)
+{
+}
+
+
+void Replacer::FreeFrame(int)
+{
+}
+
+
+void Replacer::ReturnFrame(int)
+{
+}
+
+
+Replacer* Replacer::Create(const char* policy, int bufSize, Frame **frames, HashTable *hashTable)
+{
+	if (NULL == policy || '\0' == policy[0] || 0 == strcasecmp(policy, "Clock"))
+	{
+		return new Clock(bufSize, frames, hashTable);
+	}
+	if (0 == strcasecmp(policy, "LRU-K"))
+	{
+		return new LRUK(bufSize, frames, DEFAULT_LRU_K);
+	}
+	if (0 == strncasecmp(policy, "LRU-", 4))
+	{
+		char* end;
+		long k = strtol(policy + 4, &end, 10);
+		if ('\0' == *end && k >= 1 && k <= MAX_LRU_K)
+		{
+			return new LRUK(bufSize, frames, (int)k);
+		}
+		return NULL;
+	}
+	if (0 == strcasecmp(policy, "2Q"))
+	{
+		return new TwoQ(bufSize, frames);
+	}
+	if (0 == strcasecmp(policy, "ARC"))
+	{
+		return new ARC(bufSize, frames);
+	}
+
+	return NULL;
+}
+
+
+Clock::Clock(int bufSize, Frame **frames, HashTable *hashTable)
+	: current(0), numOfBuf(bufSize), frames(frames), hashTable(hashTable)
+{
+}
+
+
+Clock::~Clock()
+{
+}
+
+
+//---------------------------------------------------------------
+// Clock::PickVictim
+//
+// Purpose : Advance the clock hand to the next frame that is empty,
+//           or unpinned and not referenced since the hand last
+//           passed it. Referenced frames get their bit cleared.
+//           Threads advance the hand together without a latch,
+//           each looking at the frames it moved the hand past.
+// Return  : The frame number, or INVALID_FRAME if every frame is
+//           pinned.
+//---------------------------------------------------------------
+
+int Clock::PickVictim()
+{
+	// Two turns clear every reference bit
+	for (int i = 0; i < 2 * numOfBuf; i++)
+	{
+		int frameNo = (int)(__atomic_fetch_add(&current, 1, __ATOMIC_RELAXED) % numOfBuf);
+
+		if (frames[frameNo]->IsVictim() && frames[frameNo]->PinForReplacement())
+		{
+			return frameNo;
+		}
+
+		if (frames[frameNo]->NotPinned())
+		{
+			frames[frameNo]->UnsetReferenced();
+		}
+	}
+
+	return INVALID_FRAME;
+}
+
+
+// The frames from the hand on that it would take if nobody pinned
+// them before it gets there, then those it takes on its next turn
+// unless they are referenced again
+int Clock::UpcomingVictims(int *frameNos, int max)
+{
+	unsigned int hand = __atomic_load_n(&current, __ATOMIC_RELAXED);
+
+	int n = 0;
+	for (int turn = 0; turn < 2; turn++)
+	{
+		for (int i = 0; i < numOfBuf && n < max; i++)
+		{
+			Frame *frame = frames[(hand + i) % numOfBuf];
+			if (frame->IsValid() && frame->NotPinned() && (0 == turn) != frame->IsReferenced())
+			{
+				frameNos[n++] = (int)((hand + i) % numOfBuf);
+			}
+		}
+	}
+
+	return n;
+}
+
+
+LinkedLists::LinkedLists(int numOfNodes, int numOfLists)
+{
+	next = new int[numOfNodes];
+	prev = new int[numOfNodes];
+	listOf = new int[numOfNodes];
+	for (int node = 0; node < numOfNodes; node++)
+	{
+		listOf[node] = -1;
+	}
+
+	heads = new int[numOfLists];
+	tails = new int[numOfLists];
+	sizes = new int[numOfLists];
+	for (int list = 0; list < numOfLists; list++)
+	{
+		heads[list] = tails[list] = -1;
+		sizes[list] = 0;
+	}
+}
+
+
+LinkedLists::~LinkedLists()
+{
+	delete[] next;
+	delete[] prev;
+	delete[] listOf;
+	delete[] heads;
+	delete[] tails;
+	delete[] sizes;
+}
+
+
+void LinkedLists::PushFront(int list, int node)
+{
+	prev[node] = -1;
+	next[node] = heads[list];
+	if (-1 == heads[list])
+	{
+		tails[list] = node;
+	}
+	else
+	{
+		prev[heads[list]] = node;
+	}
+	heads[list] = node;
+
+	listOf[node] = list;
+	sizes[list]++;
+}
+
+
+void LinkedLists::Remove(int node)
+{
+	int list = listOf[node];
+	if (-1 == list)
+	{
+		return;
+	}
+
+	if (-1 == prev[node])
+	{
+		heads[list] = next[node];
+	}
+	else
+	{
+		next[prev[node]] = next[node];
+	}
+
+	if (-1 == next[node])
+	{
+		tails[list] = prev[node];
+	}
+	else
+	{
+		prev[next[node]] = prev[node];
+	}
+
+	listOf[node] = -1;
+	sizes[list]--;
+}
+
+
+void LinkedLists::PushBack(int list, int node)
+{
+	next[node] = -1;
+	prev[node] = tails[list];
+	if (-1 == tails[list])
+	{
+		heads[list] = node;
+	}
+	else
+	{
+		next[tails[list]] = node;
+	}
+	tails[list] = node;
+
+	listOf[node] = list;
+	sizes[list]++;
+}
+
+
+int LinkedLists::Front(int list)
+{
+	return heads[list];
+}
+
+
+int LinkedLists::Back(int list)
+{
+	return tails[list];
+}
+
+
+int LinkedLists::Prev(int node)
+{
+	return prev[node];
+}
+
+
+int LinkedLists::Size(int list)
+{
+	return sizes[list];
+}
+
+
+int LinkedLists::ListOf(int node)
+{
+	return listOf[node];
+}
+
+
+GhostLists::GhostLists(int capacity, int numOfLists)
+	: lists(capacity, numOfLists + 1), nodeOf(capacity), numOfLists(numOfLists)
+{
+	pids = new PageID[capacity];
+	for (int node = 0; node < capacity; node++)
+	{
+		lists.PushFront(numOfLists, node);
+	}
+}
+
+
+GhostLists::~GhostLists()
+{
+	delete[] pids;
+}
+
+
+void GhostLists::Add(int list, PageID pid)
+{
+	Remove(pid);
+
+	if (0 == lists.Size(numOfLists))
+	{
+		int longest = 0;
+		for (int i = 1; i < numOfLists; i++)
+		{
+			if (lists.Size(i) > lists.Size(longest))
+			{
+				longest = i;
+			}
+		}
+		RemoveOldest(longest);
+	}
+
+	int node = lists.Back(numOfLists);
+	lists.Remove(node);
+
+	pids[node] = pid;
+	lists.PushFront(list, node);
+	nodeOf.Insert(pid, node);
+}
+
+
+int GhostLists::Find(PageID pid)
+{
+	int node = nodeOf.LookUp(pid);
+	return (INVALID_FRAME == node) ? -1 : lists.ListOf(node);
+}
+
+
+void GhostLists::Remove(PageID pid)
+{
+	int node = nodeOf.LookUp(pid);
+	if (INVALID_FRAME == node)
+	{
+		return;
+	}
+
+	nodeOf.Delete(pid);
+	lists.Remove(node);
+	lists.PushFront(numOfLists, node);
+}
+
+
+void GhostLists::RemoveOldest(int list)
+{
+	int node = lists.Back(list);
+	if (-1 != node)
+	{
+		Remove(pids[node]);
+	}
+}
+
+
+int GhostLists::Size(int list)
+{
+	return lists.Size(list);
+}
+
+
+// The least recently used frame of the list that is not pinned,
+// pinned for replacement, or INVALID_FRAME
+static int LeastRecentUnpinned(LinkedLists &lists, int list, Frame **frames)
+{
+	for (int frameNo = lists.Back(list); -1 != frameNo; frameNo = lists.Prev(frameNo))
+	{
+		if (frames[frameNo]->PinForReplacement())
+		{
+			return frameNo;
+		}
+	}
+
+	return INVALID_FRAME;
+}
+
+
+// Add the unpinned pages of the list to frameNos, least recently
+// used first, going from frameNo towards the front past at most
+// count frames (-1 for all). frameNo is left where to go on from,
+// -1 at the front. Returns the new number of frames in frameNos.
+static int AddUnpinned(LinkedLists &lists, int &frameNo, int count, Frame **frames, int *frameNos, int n, int max)
+{
+	for (; -1 != frameNo && 0 != count && n < max; frameNo = lists.Prev(frameNo), count--)
+	{
+		if (frames[frameNo]->IsValid() && frames[frameNo]->NotPinned())
+		{
+			frameNos[n++] = frameNo;
+		}
+	}
+
+	return n;
+}
+
+
+// A frame LRU-K may evict, by the references it compares
+struct Candidate
+{
+	long kthReference;
+	long lastReference;
+	int frameNo;
+};
+
+
+static int CompareCandidates(const void* a, const void* b)
+{
+	const Candidate* candidateA = (const Candidate*)a;
+	const Candidate* candidateB = (const Candidate*)b;
+
+	if (candidateA->kthReference != candidateB->kthReference)
+	{
+		return (candidateA->kthReference < candidateB->kthReference) ? -1 : 1;
+	}
+	if (candidateA->lastReference != candidateB->lastReference)
+	{
+		return (candidateA->lastReference < candidateB->lastReference) ? -1 : 1;
+	}
+	return 0;
+}
+
+
+LRUK::LRUK(int bufSize, Frame **frames, int k)
+	: k(k), numOfBuf(bufSize), frames(frames), time(0), nextRetained(0), retainedSlot(bufSize), heapSize(bufSize)
+{
+	history = new long[numOfBuf * k];
+	retainedHistory = new long[numOfBuf * k];
+	memset(history, 0, numOfBuf * k * sizeof(long));
+
+	retainedPids = new PageID[numOfBuf];
+	for (int i = 0; i < numOfBuf; i++)
+	{
+		retainedPids[i] = INVALID_PAGE;
+	}
+
+	// With no references yet, frame number order is heap order
+	heap = new int[numOfBuf];
+	heapPos = new int[numOfBuf];
+	passedOver = new int[numOfBuf];
+	for (int i = 0; i < numOfBuf; i++)
+	{
+		heap[i] = i;
+		heapPos[i] = i;
+	}
+}
+
+
+LRUK::~LRUK()
+{
+	delete[] history;
+	delete[] retainedHistory;
+	delete[] retainedPids;
+	delete[] heap;
+	delete[] heapPos;
+	delete[] passedOver;
+}
+
+
+void LRUK::Reference(int frameNo)
+{
+	long *times = history + frameNo * k;
+	memmove(times + 1, times, (k - 1) * sizeof(long));
+	times[0] = ++time;
+}
+
+
+// Whether frameA is to be evicted before frameB: the older K-th
+// latest reference first, then the older latest one. An empty frame
+// has no references, so it comes before every page.
+bool LRUK::Precedes(int frameA, int frameB)
+{
+	long *timesA = history + frameA * k;
+	long *timesB = history + frameB * k;
+
+	if (timesA[k - 1] != timesB[k - 1])
+	{
+		return timesA[k - 1] < timesB[k - 1];
+	}
+	if (timesA[0] != timesB[0])
+	{
+		return timesA[0] < timesB[0];
+	}
+	return frameA < frameB;
+}
+
+
+void LRUK::SiftUp(int pos)
+{
+	int frameNo = heap[pos];
+	while (0 < pos && Precedes(frameNo, heap[(pos - 1) / 2]))
+	{
+		heap[pos] = heap[(pos - 1) / 2];
+		heapPos[heap[pos]] = pos;
+		pos = (pos - 1) / 2;
+	}
+	heap[pos] = frameNo;
+	heapPos[frameNo] = pos;
+}
+
+
+void LRUK::SiftDown(int pos)
+{
+	int frameNo = heap[pos];
+	while (true)
+	{
+		int child = 2 * pos + 1;
+		if (child >= heapSize)
+		{
+			break;
+		}
+		if (child + 1 < heapSize && Precedes(heap[child + 1], heap[child]))
+		{
+			child++;
+		}
+		if (!Precedes(heap[child], frameNo))
+		{
+			break;
+		}
+		heap[pos] = heap[child];
+		heapPos[heap[pos]] = pos;
+		pos = child;
+	}
+	heap[pos] = frameNo;
+	heapPos[frameNo] = pos;
+}
+
+
+// Move the frame to its place in the heap after its references
+// changed, or enter it if PickVictim had taken it out
+void LRUK::Reposition(int frameNo)
+{
+	int pos = heapPos[frameNo];
+	if (-1 == pos)
+	{
+		pos = heapSize++;
+		heap[pos] = frameNo;
+	}
+
+	SiftUp(pos);
+	SiftDown(heapPos[frameNo]);
+}
+
+
+//---------------------------------------------------------------
+// LRUK::PickVictim
+//
+// Purpose : Pick an empty frame, else the unpinned frame whose K-th
+//           latest reference is the oldest (0 if it has fewer), ties
+//           going to the least recently used. The frames are taken
+//           off the heap in that order until one can be pinned for
+//           replacement; the pinned ones passed over go back. The
+//           victim stays off the heap until it is loaded or
+//           returned. The history of the evicted page is retained,
+//           overwriting the oldest one retained.
+// Return  : The frame number, or INVALID_FRAME if every frame is
+//           pinned.
+//---------------------------------------------------------------
+
+int LRUK::PickVictim()
+{
+	pthread_mutex_lock(&latch);
+
+	int victim = INVALID_FRAME;
+	int numOfPassedOver = 0;
+	while (0 < heapSize)
+	{
+		int frameNo = heap[0];
+		heapPos[frameNo] = -1;
+		heap[0] = heap[--heapSize];
+		if (0 < heapSize)
+		{
+			SiftDown(0);
+		}
+
+		if (frames[frameNo]->NotPinned() && frames[frameNo]->PinForReplacement())
+		{
+			victim = frameNo;
+			break;
+		}
+		passedOver[numOfPassedOver++] = frameNo;
+	}
+
+	for (int i = 0; i < numOfPassedOver; i++)
+	{
+		Reposition(passedOver[i]);
+	}
+
+	if (INVALID_FRAME != victim && frames[victim]->IsValid())
+	{
+		// The slot may hold a page that was read again and is
+		// retained in a later slot by now
+		PageID oldPid = retainedPids[nextRetained];
+		if (INVALID_PAGE != oldPid && nextRetained == retainedSlot.LookUp(oldPid))
+		{
+			retainedSlot.Delete(oldPid);
+		}
+
+		PageID pid = frames[victim]->GetPageID();
+		retainedPids[nextRetained] = pid;
+		memcpy(retainedHistory + nextRetained * k, history + victim * k, k * sizeof(long));
+		retainedSlot.Insert(pid, nextRetained);
+
+		nextRetained = (nextRetained + 1) % numOfBuf;
+	}
+
+	pthread_mutex_unlock(&latch);
+	return victim;
+}
+
+
+// The unpinned pages ordered as PickVictim compares them
+int LRUK::UpcomingVictims(int *frameNos, int max)
+{
+	Candidate *candidates = new Candidate[numOfBuf];
+	int numOfCandidates = 0;
+
+	pthread_mutex_lock(&latch);
+	for (int frameNo = 0; frameNo < numOfBuf; frameNo++)
+	{
+		if (frames[frameNo]->IsValid() && frames[frameNo]->NotPinned())
+		{
+			long *times = history + frameNo * k;
+			candidates[numOfCandidates].kthReference = times[k - 1];
+			candidates[numOfCandidates].lastReference = times[0];
+			candidates[numOfCandidates].frameNo = frameNo;
+			numOfCandidates++;
+		}
+	}
+	pthread_mutex_unlock(&latch);
+
+	qsort(candidates, numOfCandidates, sizeof(Candidate), CompareCandidates);
+
+	int n = (numOfCandidates < max) ? numOfCandidates : max;
+	for (int i = 0; i < n; i++)
+	{
+		frameNos[i] = candidates[i].frameNo;
+	}
+
+	delete[] candidates;
+	return n;
+}
+
+
+void LRUK::AccessFrame(int frameNo)
+{
+	pthread_mutex_lock(&latch);
+	Reference(frameNo);
+	if (-1 != heapPos[frameNo])
+	{
+		SiftDown(heapPos[frameNo]);
+	}
+	pthread_mutex_unlock(&latch);
+}
+
+
+void LRUK::LoadFrame(int frameNo)
+{
+	pthread_mutex_lock(&latch);
+
+	long *times = history + frameNo * k;
+	memset(times, 0, k * sizeof(long));
+
+	PageID pid = frames[frameNo]->GetPageID();
+	int slot = retainedSlot.LookUp(pid);
+	if (INVALID_FRAME != slot)
+	{
+		memcpy(times, retainedHistory + slot * k, k * sizeof(long));
+		retainedSlot.Delete(pid);
+		retainedPids[slot] = INVALID_PAGE;
+	}
+
+	Reference(frameNo);
+	Reposition(frameNo);
+
+	pthread_mutex_unlock(&latch);
+}
+
+
+void LRUK::FreeFrame(int frameNo)
+{
+	pthread_mutex_lock(&latch);
+	memset(history + frameNo * k, 0, k * sizeof(long));
+	Reposition(frameNo);
+	pthread_mutex_unlock(&latch);
+}
+
+
+void LRUK::ReturnFrame(int frameNo)
+{
+	pthread_mutex_lock(&latch);
+	Reposition(frameNo);
+	pthread_mutex_unlock(&latch);
+}
+
+
+TwoQ::TwoQ(int bufSize, Frame **frames)
+	: numOfBuf(bufSize), frames(frames), maxA1in((bufSize < 4) ? 1 : bufSize / 4),
+	  lists(bufSize, NUM_OF_LISTS), a1out((bufSize < 2) ? 1 : bufSize / 2, 1)
+{
+	for (int frameNo = 0; frameNo < numOfBuf; frameNo++)
+	{
+		lists.PushFront(FREE, frameNo);
+	}
+}
+
+
+TwoQ::~TwoQ()
+{
+}
+
+
+//---------------------------------------------------------------
+// TwoQ::PickVictim
+//
+// Purpose : Pick a free frame, else the oldest unpinned page of
+//           A1in while A1in is over its size, else the least
+//           recently used unpinned page of Am. Pages evicted from
+//           A1in are remembered in A1out.
+// Return  : The frame number, or INVALID_FRAME if every frame is
+//           pinned.
+//---------------------------------------------------------------
+
+int TwoQ::PickVictim()
+{
+	pthread_mutex_lock(&latch);
+
+	int victim = LeastRecentUnpinned(lists, FREE, frames);
+	if (INVALID_FRAME != victim)
+	{
+		lists.Remove(victim);
+		pthread_mutex_unlock(&latch);
+		return victim;
+	}
+
+	if (lists.Size(A1IN) > maxA1in)
+	{
+		victim = LeastRecentUnpinned(lists, A1IN, frames);
+	}
+	if (INVALID_FRAME == victim)
+	{
+		victim = LeastRecentUnpinned(lists, AM, frames);
+	}
+	if (INVALID_FRAME == victim)
+	{
+		victim = LeastRecentUnpinned(lists, A1IN, frames);
+	}
+	if (INVALID_FRAME != victim)
+	{
+		if (A1IN == lists.ListOf(victim) && frames[victim]->IsValid())
+		{
+			a1out.Add(0, frames[victim]->GetPageID());
+		}
+		lists.Remove(victim);
+	}
+
+	pthread_mutex_unlock(&latch);
+	return victim;
+}
+
+
+// A1in while it is over its size, then Am, then the rest of A1in
+int TwoQ::UpcomingVictims(int *frameNos, int max)
+{
+	pthread_mutex_lock(&latch);
+
+	int excess = lists.Size(A1IN) - maxA1in;
+	int a1in = lists.Back(A1IN);
+	int am = lists.Back(AM);
+
+	int n = AddUnpinned(lists, a1in, (excess > 0) ? excess : 0, frames, frameNos, 0, max);
+	n = AddUnpinned(lists, am, -1, frames, frameNos, n, max);
+	n = AddUnpinned(lists, a1in, -1, frames, frameNos, n, max);
+
+	pthread_mutex_unlock(&latch);
+	return n;
+}
+
+
+void TwoQ::AccessFrame(int frameNo)
+{
+	pthread_mutex_lock(&latch);
+
+	// Re-references while in A1in are taken to be correlated
+	if (AM == lists.ListOf(frameNo))
+	{
+		lists.Remove(frameNo);
+		lists.PushFront(AM, frameNo);
+	}
+
+	pthread_mutex_unlock(&latch);
+}
+
+
+void TwoQ::LoadFrame(int frameNo)
+{
+	pthread_mutex_lock(&latch);
+
+	lists.Remove(frameNo);
+
+	PageID pid = frames[frameNo]->GetPageID();
+	if (-1 != a1out.Find(pid))
+	{
+		a1out.Remove(pid);
+		lists.PushFront(AM, frameNo);
+	}
+	else
+	{
+		lists.PushFront(A1IN, frameNo);
+	}
+
+	pthread_mutex_unlock(&latch);
+}
+
+
+void TwoQ::FreeFrame(int frameNo)
+{
+	pthread_mutex_lock(&latch);
+	lists.Remove(frameNo);
+	lists.PushFront(FREE, frameNo);
+	pthread_mutex_unlock(&latch);
+}
+
+
+// Back to the end of the list it was evicted from: A1in if A1out
+// remembers it, else Am, or the free list if it is empty
+void TwoQ::ReturnFrame(int frameNo)
+{
+	pthread_mutex_lock(&latch);
+
+	if (-1 == lists.ListOf(frameNo))
+	{
+		PageID pid = frames[frameNo]->GetPageID();
+		if (INVALID_PAGE == pid)
+		{
+			lists.PushBack(FREE, frameNo);
+		}
+		else if (-1 != a1out.Find(pid))
+		{
+			a1out.Remove(pid);
+			lists.PushBack(A1IN, frameNo);
+		}
+		else
+		{
+			lists.PushBack(AM, frameNo);
+		}
+	}
+
+	pthread_mutex_unlock(&latch);
+}
+
+
+ARC::ARC(int bufSize, Frame **frames)
+	: numOfBuf(bufSize), frames(frames), target(0), lists(bufSize, NUM_OF_LISTS), ghosts(2 * bufSize, NUM_OF_GHOST_LISTS)
+{
+	for (int frameNo = 0; frameNo < numOfBuf; frameNo++)
+	{
+		lists.PushFront(FREE, frameNo);
+	}
+}
+
+
+ARC::~ARC()
+{
+}
+
+
+//---------------------------------------------------------------
+// ARC::PickVictim
+//
+// Purpose : Pick a free frame, else the least recently used
+//           unpinned page of T1 if T1 is larger than its target,
+//           else that of T2. The page is remembered in B1 or B2.
+// Return  : The frame number, or INVALID_FRAME if every frame is
+//           pinned.
+//---------------------------------------------------------------
+
+int ARC::PickVictim()
+{
+	pthread_mutex_lock(&latch);
+
+	int victim = LeastRecentUnpinned(lists, FREE, frames);
+	if (INVALID_FRAME != victim)
+	{
+		lists.Remove(victim);
+		pthread_mutex_unlock(&latch);
+		return victim;
+	}
+
+	if (lists.Size(T1) > target)
+	{
+		victim = LeastRecentUnpinned(lists, T1, frames);
+	}
+	if (INVALID_FRAME == victim)
+	{
+		victim = LeastRecentUnpinned(lists, T2, frames);
+	}
+	if (INVALID_FRAME == victim)
+	{
+		victim = LeastRecentUnpinned(lists, T1, frames);
+	}
+	if (INVALID_FRAME != victim)
+	{
+		if (frames[victim]->IsValid())
+		{
+			ghosts.Add((T1 == lists.ListOf(victim)) ? B1 : B2, frames[victim]->GetPageID());
+		}
+		lists.Remove(victim);
+	}
+
+	pthread_mutex_unlock(&latch);
+	return victim;
+}
+
+
+// T1 while it is over its target, then T2, then the rest of T1
+int ARC::UpcomingVictims(int *frameNos, int max)
+{
+	pthread_mutex_lock(&latch);
+
+	int excess = lists.Size(T1) - target;
+	int t1 = lists.Back(T1);
+	int t2 = lists.Back(T2);
+
+	int n = AddUnpinned(lists, t1, (excess > 0) ? excess : 0, frames, frameNos, 0, max);
+	n = AddUnpinned(lists, t2, -1, frames, frameNos, n, max);
+	n = AddUnpinned(lists, t1, -1, frames, frameNos, n, max);
+
+	pthread_mutex_unlock(&latch);
+	return n;
+}
+
+
+void ARC::AccessFrame(int frameNo)
+{
+	pthread_mutex_lock(&latch);
+	lists.Remove(frameNo);
+	lists.PushFront(T2, frameNo);
+	pthread_mutex_unlock(&latch);
+}
+
+
+//---------------------------------------------------------------
+// ARC::LoadFrame
+//
+// Purpose : Put a page read again after its eviction into T2,
+//           moving the target of T1 up for a ghost of B1 and down
+//           for one of B2, by the ratio of the ghost list sizes.
+//           Other pages go into T1. The ghost lists are then cut
+//           back so that T1 and B1 together, and all four lists
+//           together, remember at most one and two pools of pages.
+//---------------------------------------------------------------
+
+void ARC::LoadFrame(int frameNo)
+{
+	pthread_mutex_lock(&latch);
+
+	lists.Remove(frameNo);
+
+	PageID pid = frames[frameNo]->GetPageID();
+	int sizeOfB1 = ghosts.Size(B1);
+	int sizeOfB2 = ghosts.Size(B2);
+
+	switch (ghosts.Find(pid))
+	{
+		case B1:
+			target += (sizeOfB2 > sizeOfB1) ? sizeOfB2 / sizeOfB1 : 1;
+			if (target > numOfBuf)
+			{
+				target = numOfBuf;
+			}
+			ghosts.Remove(pid);
+			lists.PushFront(T2, frameNo);
+			break;
+
+		case B2:
+			target -= (sizeOfB1 > sizeOfB2) ? sizeOfB1 / sizeOfB2 : 1;
+			if (target < 0)
+			{
+				target = 0;
+			}
+			ghosts.Remove(pid);
+			lists.PushFront(T2, frameNo);
+			break;
+
+		default:
+			lists.PushFront(T1, frameNo);
+			break;
+	}
+
+	while (ghosts.Size(B1) > 0 && lists.Size(T1) + ghosts.Size(B1) > numOfBuf)
+	{
+		ghosts.RemoveOldest(B1);
+	}
+	while (ghosts.Size(B2) > 0 && lists.Size(T1) + lists.Size(T2) + ghosts.Size(B1) + ghosts.Size(B2) > 2 * numOfBuf)
+	{
+		ghosts.RemoveOldest(B2);
+	}
+
+	pthread_mutex_unlock(&latch);
+}
+
+
+void ARC::FreeFrame(int frameNo)
+{
+	pthread_mutex_lock(&latch);
+	lists.Remove(frameNo);
+	lists.PushFront(FREE, frameNo);
+	pthread_mutex_unlock(&latch);
+}
+
+
+// Back to the end of the list it was evicted from, without the
+// ghost its eviction left, or to the free list if it is empty
+void ARC::ReturnFrame(int frameNo)
+{
+	pthread_mutex_lock(&latch);
+
+	if (-1 == lists.ListOf(frameNo))
+	{
+		PageID pid = frames[frameNo]->GetPageID();
+		if (INVALID_PAGE == pid)
+		{
+			lists.PushBack(FREE, frameNo);
+		}
+		else
+		{
+			lists.PushBack((B2 == ghosts.Find(pid)) ? T2 : T1, frameNo);
+			ghosts.Remove(pid);
+		}
+	}
+
+	pthread_mutex_unlock(&latch);
+}
@@ -0,0 +1,615 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "include/minirel.h"
+#include "include/bufmgr.h"
+
+#define TEST_DB_NAME  "BUFMGRTEST.DB"
+#define TEST_LOG_NAME "BUFMGRTEST.LOG"
+#define NUM_OF_TEST_DB_PAGES 500
+
+// Concurrent access: threads pin pages of a shared set far larger than
+// the pool, so that the pages are evicted and read back all the time
+#define NUM_OF_STRESS_THREADS      8
+#define NUM_OF_STRESS_BUF_PAGES    16
+#define NUM_OF_SHARED_PAGES        64
+#define NUM_OF_STRESS_OPERATIONS   2000
+
+// A page of the shared set: its own ID, and how often each thread has
+// pinned it; each thread only counts in its own slot
+typedef struct SharedPage {
+	PageID pid;
+	int numOfPins[NUM_OF_STRESS_THREADS];
+} SharedPage;
+
+// What a stress thread works on and what it found
+typedef struct StressThread {
+	int no;
+	unsigned int seed;
+	PageID* sharedPids;
+	int numOfPins[NUM_OF_SHARED_PAGES];   // pins of each shared page
+	int numOfErrors;
+} StressThread;
+
+// Replacement policies: a small pool sees a hot set of two pages, a
+// scan of three pages, the hot set, two more scanned pages and the hot
+// set once more
+#define REPLACER_TEST_BUF_PAGES 4
+#define MAX_REPLACER_TEST_VICTIMS 8
+
+static const PageID referenceString[] = { 1, 2, 1, 2, 10, 11, 12, 1, 2, 13, 14, 1, 2 };
+
+// What a policy is to do with the reference string: how many of the
+// references miss, and the pages it evicts in order, up to INVALID_PAGE
+typedef struct ReplacerCase {
+	const char* policy;
+	int numOfMisses;
+	PageID victims[MAX_REPLACER_TEST_VICTIMS];
+} ReplacerCase;
+
+// Flushes: pages of a run allocated at once, some dirtied next to each
+// other so that one write covers them, and some on their own
+#define FLUSH_TEST_BUF_PAGES    16
+#define NUM_OF_FLUSH_TEST_PAGES 8
+
+void TestConcurrentAccess();
+void TestReplacementPolicies();
+void TestFlush();
+
+
+int RunBufMgrTests()
+{
+	TestReplacementPolicies();
+	TestFlush();
+	TestConcurrentAccess();
+
+	return 0;
+}
+
+
+// Create a fresh database with a pool of numOfBufPages frames
+static Status StartMinibase(int numOfBufPages)
+{
+	std::remove(TEST_DB_NAME);
+
+	Status status;
+	minibase_globals = new SystemDefs(status,
+		TEST_DB_NAME,
+		TEST_LOG_NAME,
+		NUM_OF_TEST_DB_PAGES,
+		500,
+		numOfBufPages,
+		NULL);
+
+	return status;
+}
+
+
+static void StopMinibase()
+{
+	delete minibase_globals;
+	minibase_globals = NULL;
+
+	std::remove(TEST_DB_NAME);
+}
+
+
+//---------------------------------------------------------------
+// RunStressThread
+//
+// Purpose : Pin, dirty and unpin random pages of the shared set,
+//           checking that each still holds its own ID, and mix in
+//           pages of the thread's own that it creates and frees
+//           again, and flushes of single pages, of the whole pool
+//           and ahead of the replacer.
+//---------------------------------------------------------------
+
+static void* RunStressThread(void* stressThread)
+{
+	StressThread* thread = (StressThread*)stressThread;
+
+	for (int i = 0; i < NUM_OF_STRESS_OPERATIONS; i++)
+	{
+		int operation = rand_r(&thread->seed) % 16;
+		int sharedPage = rand_r(&thread->seed) % NUM_OF_SHARED_PAGES;
+		PageID pid = thread->sharedPids[sharedPage];
+		Page* page;
+
+		if (operation < 12)
+		{
+			if (OK != MINIBASE_BM->PinPage(pid, page))
+			{
+				thread->numOfErrors++;
+				continue;
+			}
+
+			SharedPage* shared = (SharedPage*)page;
+			if (pid != shared->pid)
+			{
+				thread->numOfErrors++;
+			}
+			shared->numOfPins[thread->no]++;
+			thread->numOfPins[sharedPage]++;
+
+			if (OK != MINIBASE_BM->UnpinPage(pid, TRUE))
+			{
+				thread->numOfErrors++;
+			}
+		}
+		else if (operation < 14)
+		{
+			PageID ownPid;
+			if (OK != MINIBASE_BM->NewPage(ownPid, page))
+			{
+				thread->numOfErrors++;
+				continue;
+			}
+			memcpy((char*)page, &ownPid, sizeof(PageID));
+
+			if (OK != MINIBASE_BM->UnpinPage(ownPid, TRUE) || OK != MINIBASE_BM->PinPage(ownPid, page))
+			{
+				thread->numOfErrors++;
+				continue;
+			}
+			if (0 != memcmp((char*)page, &ownPid, sizeof(PageID)))
+			{
+				thread->numOfErrors++;
+			}
+
+			// Freed with the thread's own pin still on it
+			if (OK != MINIBASE_BM->FreePage(ownPid))
+			{
+				thread->numOfErrors++;
+			}
+		}
+		else if (14 == operation)
+		{
+			// FAIL if the page is not in the pool
+			MINIBASE_BM->FlushPage(pid);
+		}
+		else if (OK != MINIBASE_BM->FlushAllPages())
+		{
+			thread->numOfErrors++;
+		}
+		else
+		{
+			MINIBASE_BM->CleanAhead(4);
+		}
+	}
+
+	return NULL;
+}
+
+
+//---------------------------------------------------------------
+// TestConcurrentAccess
+//
+// Purpose : Let NUM_OF_STRESS_THREADS threads use a small pool at
+//           once under each replacement policy, then check that no
+//           frame is left pinned, that the page table is sound and
+//           that every pin of a shared page is counted on it, so
+//           that no change was lost when the page was evicted.
+//---------------------------------------------------------------
+
+void TestConcurrentAccess()
+{
+	if (OK != StartMinibase(NUM_OF_STRESS_BUF_PAGES))
+	{
+		cerr << "FAIL: cannot create the database for the concurrent buffer manager test.\n";
+		return;
+	}
+
+	int numOfErrors = 0;
+
+	PageID sharedPids[NUM_OF_SHARED_PAGES];
+	for (int i = 0; i < NUM_OF_SHARED_PAGES; i++)
+	{
+		Page* page;
+		if (OK != MINIBASE_BM->NewPage(sharedPids[i], page))
+		{
+			cerr << "FAIL: cannot create the shared pages for the concurrent buffer manager test.\n";
+			StopMinibase();
+			return;
+		}
+
+		SharedPage shared;
+		memset(&shared, 0, sizeof(SharedPage));
+		shared.pid = sharedPids[i];
+		memcpy((char*)page, &shared, sizeof(SharedPage));
+
+		MINIBASE_BM->UnpinPage(sharedPids[i], TRUE);
+	}
+
+	StressThread threads[NUM_OF_STRESS_THREADS];
+	for (int t = 0; t < NUM_OF_STRESS_THREADS; t++)
+	{
+		memset(&threads[t], 0, sizeof(StressThread));
+		threads[t].no = t;
+		threads[t].seed = t + 1;
+		threads[t].sharedPids = sharedPids;
+	}
+
+	const char* replacementPolicies[] = { "Clock", "LRU-K", "2Q", "ARC" };
+	const int numOfPolicies = sizeof(replacementPolicies) / sizeof(replacementPolicies[0]);
+
+	for (int policyIndex = 0; policyIndex < numOfPolicies; policyIndex++)
+	{
+		MINIBASE_BM->SetReplacementPolicy(replacementPolicies[policyIndex]);
+
+		pthread_t pthreads[NUM_OF_STRESS_THREADS];
+		int numOfStarted = 0;
+		while (numOfStarted < NUM_OF_STRESS_THREADS && 0 == pthread_create(&pthreads[numOfStarted], NULL, RunStressThread, &threads[numOfStarted]))
+		{
+			numOfStarted++;
+		}
+		for (int t = 0; t < numOfStarted; t++)
+		{
+			pthread_join(pthreads[t], NULL);
+		}
+
+		if (numOfStarted < NUM_OF_STRESS_THREADS)
+		{
+			cerr << "ERROR: only " << numOfStarted << " stress threads started under " << replacementPolicies[policyIndex] << ".\n";
+			numOfErrors++;
+		}
+
+		if (OK != MINIBASE_BM->CheckPool())
+		{
+			cerr << "ERROR: the pool is inconsistent after the stress threads ran under " << replacementPolicies[policyIndex] << ".\n";
+			numOfErrors++;
+		}
+	}
+
+	for (int t = 0; t < NUM_OF_STRESS_THREADS; t++)
+	{
+		numOfErrors += threads[t].numOfErrors;
+	}
+
+	for (int i = 0; i < NUM_OF_SHARED_PAGES; i++)
+	{
+		Page* page;
+		if (OK != MINIBASE_BM->PinPage(sharedPids[i], page))
+		{
+			numOfErrors++;
+			continue;
+		}
+
+		SharedPage shared;
+		memcpy(&shared, (char*)page, sizeof(SharedPage));
+		MINIBASE_BM->UnpinPage(sharedPids[i]);
+
+		if (sharedPids[i] != shared.pid)
+		{
+			cerr << "ERROR: page " << sharedPids[i] << " holds page " << shared.pid << ".\n";
+			numOfErrors++;
+			continue;
+		}
+
+		for (int t = 0; t < NUM_OF_STRESS_THREADS; t++)
+		{
+			if (threads[t].numOfPins[i] != shared.numOfPins[t])
+			{
+				cerr << "ERROR: page " << sharedPids[i] << " counts " << shared.numOfPins[t] << " pins by thread " << t << " instead of " << threads[t].numOfPins[i] << ".\n";
+				numOfErrors++;
+			}
+		}
+	}
+
+	StopMinibase();
+
+	if (0 == numOfErrors)
+	{
+		cout << "PASS: threads pinning, dirtying, unpinning and freeing pages at once leave the pool consistent and lose no change.\n";
+	}
+	else
+	{
+		cerr << "FAIL: threads using the buffer manager at once caused " << numOfErrors << " errors.\n";
+	}
+}
+
+
+//---------------------------------------------------------------
+// RunReferenceString
+//
+// Purpose : Reference the pages of referenceString in a pool of
+//           REPLACER_TEST_BUF_PAGES frames managed by the policy,
+//           one page at a time, with the calls the buffer manager
+//           makes into its replacer for a hit and a miss.
+// Output  : victims      - the pages evicted, in order.
+//           numOfVictims - how many there are.
+// Return  : The number of misses, or -1 if the policy is unknown
+//           or picked no frame.
+//---------------------------------------------------------------
+
+static int RunReferenceString(const char* policy, PageID* victims, int& numOfVictims)
+{
+	int numOfUnpinnedFrames = REPLACER_TEST_BUF_PAGES;
+	Frame* frames[REPLACER_TEST_BUF_PAGES];
+	for (int i = 0; i < REPLACER_TEST_BUF_PAGES; i++)
+	{
+		frames[i] = new Frame(&numOfUnpinnedFrames);
+	}
+	HashTable hashTable(REPLACER_TEST_BUF_PAGES);
+
+	Replacer* replacer = Replacer::Create(policy, REPLACER_TEST_BUF_PAGES, frames, &hashTable);
+
+	int numOfMisses = (NULL == replacer) ? -1 : 0;
+	numOfVictims = 0;
+
+	const int numOfReferences = sizeof(referenceString) / sizeof(referenceString[0]);
+	for (int i = 0; i < numOfReferences && -1 != numOfMisses; i++)
+	{
+		PageID pid = referenceString[i];
+
+		int frameNo = hashTable.LookUp(pid);
+		if (INVALID_FRAME != frameNo)
+		{
+			frames[frameNo]->Pin();
+			replacer->AccessFrame(frameNo);
+		}
+		else
+		{
+			numOfMisses++;
+
+			frameNo = replacer->PickVictim();
+			if (INVALID_FRAME == frameNo)
+			{
+				numOfMisses = -1;
+				break;
+			}
+
+			if (frames[frameNo]->IsValid())
+			{
+				if (numOfVictims < MAX_REPLACER_TEST_VICTIMS)
+				{
+					victims[numOfVictims++] = frames[frameNo]->GetPageID();
+				}
+				hashTable.Delete(frames[frameNo]->GetPageID());
+			}
+			frames[frameNo]->StartRead(pid, FALSE);
+			hashTable.Insert(pid, frameNo);
+			replacer->LoadFrame(frameNo);
+			frames[frameNo]->EndRead(OK);
+		}
+
+		frames[frameNo]->Unpin();
+	}
+
+	delete replacer;
+	for (int i = 0; i < REPLACER_TEST_BUF_PAGES; i++)
+	{
+		delete frames[i];
+	}
+
+	return numOfMisses;
+}
+
+
+//---------------------------------------------------------------
+// TestReplacementPolicies
+//
+// Purpose : Check the misses and the order of the victims of each
+//           replacement policy on referenceString. The scans flush
+//           the hot set out of Clock, and out of 2Q, which takes
+//           the second reference to a page in A1in as correlated;
+//           LRU-2 and ARC keep it.
+//---------------------------------------------------------------
+
+void TestReplacementPolicies()
+{
+	const ReplacerCase cases[] = {
+		{ "Clock",  9, { 1, 2, 10, 11, 12, INVALID_PAGE } },
+		{ "LRU-K",  7, { 10, 11, 12, INVALID_PAGE } },
+		{ "2Q",     9, { 1, 2, 10, 11, 12, INVALID_PAGE } },
+		{ "ARC",    7, { 10, 11, 12, INVALID_PAGE } }
+	};
+	const int numOfCases = sizeof(cases) / sizeof(cases[0]);
+
+	int numOfErrors = 0;
+
+	for (int c = 0; c < numOfCases; c++)
+	{
+		PageID victims[MAX_REPLACER_TEST_VICTIMS];
+		int numOfVictims;
+		int numOfMisses = RunReferenceString(cases[c].policy, victims, numOfVictims);
+
+		if (cases[c].numOfMisses != numOfMisses)
+		{
+			cerr << "ERROR: " << cases[c].policy << " misses " << numOfMisses << " references instead of " << cases[c].numOfMisses << ".\n";
+			numOfErrors++;
+		}
+
+		for (int i = 0; i <= numOfVictims && i < MAX_REPLACER_TEST_VICTIMS; i++)
+		{
+			PageID victim = (i < numOfVictims) ? victims[i] : INVALID_PAGE;
+			if (cases[c].victims[i] != victim)
+			{
+				cerr << "ERROR: " << cases[c].policy << " evicts page " << victim << " instead of page " << cases[c].victims[i] << " as victim " << i + 1 << ".\n";
+				numOfErrors++;
+				break;
+			}
+			if (INVALID_PAGE == victim)
+			{
+				break;
+			}
+		}
+	}
+
+	if (0 == numOfErrors)
+	{
+		cout << "PASS: each replacement policy evicts the expected pages on a scan mixed with a hot set.\n";
+	}
+	else
+	{
+		cerr << "FAIL: the replacement policies made " << numOfErrors << " errors on a scan mixed with a hot set.\n";
+	}
+}
+
+
+// Fill the page with a byte that tells the page and its version apart
+// from the other pages of the flush test
+static void FillPage(Page* page, PageID pid, int version)
+{
+	memset((char*)page, (pid * 16 + version) & 0xff, MINIBASE_PAGESIZE);
+}
+
+
+static bool IsFilled(Page* page, PageID pid, int version)
+{
+	const char* data = (char*)page;
+	for (int i = 0; i < MINIBASE_PAGESIZE; i++)
+	{
+		if (((pid * 16 + version) & 0xff) != (data[i] & 0xff))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// Pin the page, fill it as its next version and unpin it dirty,
+// pinning it again if keepPinned
+static Status WritePage(PageID pid, int& version, bool keepPinned)
+{
+	Page* page;
+	if (OK != MINIBASE_BM->PinPage(pid, page))
+	{
+		return FAIL;
+	}
+
+	FillPage(page, pid, ++version);
+
+	if (OK != MINIBASE_BM->UnpinPage(pid, TRUE))
+	{
+		return FAIL;
+	}
+	return keepPinned ? MINIBASE_BM->PinPage(pid, page) : OK;
+}
+
+
+//---------------------------------------------------------------
+// TestFlush
+//
+// Purpose : Dirty a run of consecutive pages and pages apart from
+//           it, flush them with FlushAllPages, then dirty some
+//           again and clean them with CleanAhead, which must pass
+//           over a pinned page. The buffer manager must count each
+//           page written, however many pages a write covers, and
+//           write no clean page. A fresh pool must then read every
+//           page back as last written.
+//---------------------------------------------------------------
+
+void TestFlush()
+{
+	if (OK != StartMinibase(FLUSH_TEST_BUF_PAGES))
+	{
+		cerr << "FAIL: cannot create the database for the flush test.\n";
+		return;
+	}
+
+	int numOfErrors = 0;
+
+	PageID firstPid;
+	Page* page;
+	if (OK != MINIBASE_BM->NewPage(firstPid, page, NUM_OF_FLUSH_TEST_PAGES))
+	{
+		cerr << "FAIL: cannot create the pages for the flush test.\n";
+		StopMinibase();
+		return;
+	}
+	MINIBASE_BM->UnpinPage(firstPid);
+
+	// Nothing written by the allocation is to count below
+	MINIBASE_BM->FlushAllPages();
+	MINIBASE_BM->ResetStat();
+
+	// The last version written of each page, 0 if none
+	int versions[NUM_OF_FLUSH_TEST_PAGES];
+	memset(versions, 0, sizeof(versions));
+
+	// A run of four pages, and two pages apart from it and each other
+	const int dirtied[] = { 0, 1, 2, 3, 5, 7 };
+	const int numOfDirtied = sizeof(dirtied) / sizeof(dirtied[0]);
+	for (int i = 0; i < numOfDirtied; i++)
+	{
+		if (OK != WritePage(firstPid + dirtied[i], versions[dirtied[i]], false))
+		{
+			numOfErrors++;
+		}
+	}
+
+	if (OK != MINIBASE_BM->FlushAllPages())
+	{
+		cerr << "ERROR: FlushAllPages failed.\n";
+		numOfErrors++;
+	}
+	if (numOfDirtied != MINIBASE_BM->GetNumOfDirtyPageWrites())
+	{
+		cerr << "ERROR: FlushAllPages counts " << MINIBASE_BM->GetNumOfDirtyPageWrites() << " pages written instead of " << numOfDirtied << ".\n";
+		numOfErrors++;
+	}
+
+	// Two consecutive pages for CleanAhead, and one it must leave
+	// alone while it is pinned
+	const int pinnedPage = 6;
+	if (OK != WritePage(firstPid + 1, versions[1], false) ||
+		OK != WritePage(firstPid + 2, versions[2], false) ||
+		OK != WritePage(firstPid + pinnedPage, versions[pinnedPage], true))
+	{
+		numOfErrors++;
+	}
+
+	unsigned int numOfCleaned = MINIBASE_BM->CleanAhead(FLUSH_TEST_BUF_PAGES);
+	if (2 != numOfCleaned)
+	{
+		cerr << "ERROR: CleanAhead wrote " << numOfCleaned << " pages instead of 2.\n";
+		numOfErrors++;
+	}
+
+	MINIBASE_BM->UnpinPage(firstPid + pinnedPage);
+
+	// The pinned page is still dirty, the others are clean
+	MINIBASE_BM->FlushAllPages();
+	MINIBASE_BM->FlushAllPages();
+	if (numOfDirtied + 3 != MINIBASE_BM->GetNumOfDirtyPageWrites())
+	{
+		cerr << "ERROR: the flushes count " << MINIBASE_BM->GetNumOfDirtyPageWrites() << " pages written instead of " << numOfDirtied + 3 << ".\n";
+		numOfErrors++;
+	}
+
+	delete MINIBASE_BM;
+	MINIBASE_BM = new BufMgr(FLUSH_TEST_BUF_PAGES);
+
+	for (int i = 0; i < NUM_OF_FLUSH_TEST_PAGES; i++)
+	{
+		if (0 == versions[i])
+		{
+			continue;
+		}
+
+		if (OK != MINIBASE_BM->PinPage(firstPid + i, page))
+		{
+			numOfErrors++;
+			continue;
+		}
+		if (!IsFilled(page, firstPid + i, versions[i]))
+		{
+			cerr << "ERROR: page " << firstPid + i << " does not hold version " << versions[i] << " after the flushes.\n";
+			numOfErrors++;
+		}
+		MINIBASE_BM->UnpinPage(firstPid + i);
+	}
+
+	StopMinibase();
+
+	if (0 == numOfErrors)
+	{
+		cout << "PASS: flushing runs of dirty pages and single ones writes each page once, counts it, and a fresh pool reads it back.\n";
+	}
+	else
+	{
+		cerr << "FAIL: flushing dirty pages caused " << numOfErrors << " errors.\n";
+	}
+}
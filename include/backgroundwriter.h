@@ -0,0 +1,43 @@
+#ifndef BACKGROUNDWRITER_H
+#define BACKGROUNDWRITER_H
+
+#include <pthread.h>
+
+#include "minirel.h"
+#include "bufmgr.h"
+
+//---------------------------------------------------------------
+// Cleans the buffer pool ahead of the replacer.
+//
+// A thread writes out, every interval milliseconds, the dirty pages
+// that nobody has pinned among the next quarter pool of frames the
+// replacer is going to evict (BufMgr::CleanAhead), so that a thread
+// that needs a frame seldom waits for a write first. Pages with
+// consecutive IDs are written together.
+//
+// The BackgroundWriter is deleted before the buffer manager is, or
+// its replacement policy is changed.
+//---------------------------------------------------------------
+
+class BackgroundWriter
+{
+	public :
+
+		BackgroundWriter(int interval);
+		~BackgroundWriter();
+
+	private :
+
+		int interval;        // in milliseconds
+		int numOfFrames;     // looked at per round
+
+		bool started;
+		bool stop;
+		pthread_t thread;
+		pthread_mutex_t lock;
+		pthread_cond_t stopped;
+
+		static void* Run(void* backgroundWriter);
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include "minirel.h"
+#include "join.h"
+#include "joinhash.h"
+
+//---------------------------------------------------------------
+// Bloom filter over the join keys of a relation.
+//
+// Keys are added and looked up by their fold (see joinkey.h). The
+// k bit positions of a key are derived from its PartitionHash and
+// BucketHash (double hashing). MayContain() never returns false
+// for a key that was added, so a key it rejects has no partner in
+// the relation the filter was built over.
+//---------------------------------------------------------------
+
+class BloomFilter
+{
+	public :
+
+		BloomFilter(int numOfKeys); // sized for numOfKeys keys
+		~BloomFilter();
+
+		void Add(int foldedKey);
+
+		bool MayContain(int foldedKey) const
+		{
+			unsigned int h1 = PartitionHash(foldedKey);
+			unsigned int h2 = BucketHash(foldedKey) | 1;
+
+			for (int i = 0; i < numOfHashes; i++)
+			{
+				unsigned int bit = (h1 + i * h2) & mask;
+				if (0 == (bits[bit >> 5] & (1u << (bit & 31))))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+	private :
+
+		unsigned int* bits;
+		unsigned int mask;  // number of bits - 1 (a power of two)
+		int numOfHashes;
+};
+
+
+// Fold of the join key of the record rec (see joinkey.h)
+int FoldJoinKey(const char* rec, const JoinSpec& spec);
+
+// Bloom filter over the join keys of a relation, or NULL if the relation
+// cannot be read in full; the join then runs without a filter
+BloomFilter* BuildJoinKeyFilter(JoinSpec spec);
+
+// Whether a join should probe a Bloom filter over S before joining the
+// R records (see JoinSpec::useBloomFilter)
+bool UseBloomFilter(const JoinSpec& specOfR);
+
+#endif
@@ -12,6 +12,18 @@ enum PrintOption
   RECURSIVE
 };
 
+// Stream of <key, rid> pairs in ascending key order, used to bulk
+// load a BTreeFile. GetNext returns DONE once the stream is exhausted,
+// or FAIL if the next pair cannot be produced.
+class BulkLoadSource {
+
+public:
+
+	virtual ~BulkLoadSource() {}
+
+	virtual Status GetNext (RecordID & rid, void* keyptr) = 0;
+};
+
 class BTreeFile: public IndexFile {
 	
 public:
@@ -26,6 +38,10 @@ public:
 	
     Status Insert(const void *key, const RecordID rid); 
     Status Delete(const void *key, const RecordID rid);
+
+	// Build an empty tree bottom-up from a key-sorted stream, filling
+	// every leaf and index page up to fillFactor of its data area.
+	Status BulkLoad(BulkLoadSource *source, float fillFactor = 1.0);
     
 	IndexFileScan *OpenScan(const void *lowKey = NULL, const void *highKey = NULL);
 
@@ -33,6 +49,10 @@ public:
 
 	IndexFileScan *OpenSearchScan(const void *lowKey = NULL, const void *highKey = NULL);
 
+	// The key type and key size the tree was created with
+	AttrType GetKeyType() { return header->keyType; }
+	int GetKeySize() { return header->keySize; }
+
 	Status PrintTree (PageID pageID, PrintOption option);
 	Status PrintWhole ();
 	Status DumpStatistics();
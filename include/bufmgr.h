@@ -8,6 +8,45 @@
 #include "replacer.h"
 #include "hash.h"
 
+// How the pages pinned by a scan are going to be used
+enum AccessHint
+{
+	ACCESS_NORMAL,          // pages compete for the whole pool
+	ACCESS_SEQUENTIAL_ONCE  // pages are read once, in order, through a BufferRing
+};
+
+
+// A few frames that the pages of one sequential scan cycle through.
+// A page the ring read earlier is evicted to make room for the next
+// one, once it is unpinned, instead of a page chosen by the
+// replacement policy, so the scan does not flush pages that other
+// work still needs out of the pool.
+class BufferRing
+{
+	friend class BufMgr;
+
+	private:
+
+		int size;
+		int next;          // slot to fill next
+		int *frameNos;     // INVALID_FRAME if the slot is unused
+		PageID *pids;      // page each slot read into its frame
+
+	public:
+
+		BufferRing( int size );
+		~BufferRing();
+};
+
+
+// Any number of threads may pin, unpin, create, free and flush
+// pages at once; see Frame and HashTable for the latching. A
+// BufferRing belongs to one thread. SetReplacementPolicy is called
+// while no other thread uses the buffer manager, a BackgroundWriter
+// included.
+//
+// The prebuilt system library allocates the BufMgr, so its fields
+// stay as they are; further state lives in bufmgr.cpp.
 class BufMgr 
 {
 	private:
@@ -18,6 +57,10 @@ class BufMgr
 		int   numOfBuf;
 
 		int FindFrame( PageID pid );
+		int PinFrame( PageID pid );
+		int PickFrame( BufferRing* ring );
+		Status PlacePage( PageID pid, BufferRing* ring, Bool prefetch, int& frameNo );
+		Status WriteFrames( const int* frameNos, int n, Bool unpinnedOnly, unsigned int& numOfWritten );
 		long totalCall;
 		long totalHit;
 		long numDirtyPageWrites;
@@ -27,20 +70,27 @@ class BufMgr
 		BufMgr( int bufsize );
 		~BufMgr();      
 		Status PinPage( PageID pid, Page*& page, Bool emptyPage=FALSE );
+		Status PinPage( PageID pid, Page*& page, Bool emptyPage, BufferRing* ring ); // ring may be NULL
 		Status UnpinPage( PageID pid, Bool dirty=FALSE );
 		Status NewPage( PageID& pid, Page*& firstpage,int howmany=1 ); 
+		Status PrefetchPage( PageID pid, Frame*& frame, BufferRing* ring ); // see ReadAhead
 		Status FreePage( PageID pid ); 
 		Status FlushPage( PageID pid );
 		Status FlushAllPages();
+		unsigned int CleanAhead( int numOfFrames ); // see BackgroundWriter
+		int GetDBFile(); // descriptor of the database file for pread/pwritev, -1 if it cannot be opened
+		Status SetReplacementPolicy(const char* policy); // "Clock", "LRU-K", "2Q" or "ARC"
 		Status  GetStat(long& pinNo, long& missNo) { pinNo = totalCall; missNo = totalCall-totalHit; return OK;}
+		long GetNumOfDirtyPageWrites() { return __atomic_load_n(&numDirtyPageWrites, __ATOMIC_RELAXED); } // pages, however many per write
 
 		unsigned int GetNumOfUnpinnedFrames();
+		Status CheckPool(); // see BufMgr::CheckPool
 
 		unsigned int GetNumOfBuffers();
 		unsigned int GetNumOfUnpinnedBuffers();
 
 		void   PrintStat();
-		void   ResetStat() { totalHit = 0; totalCall = 0; numDirtyPageWrites = 0;}
+		void   ResetStat() { __atomic_store_n(&totalHit, 0, __ATOMIC_RELAXED); __atomic_store_n(&totalCall, 0, __ATOMIC_RELAXED); __atomic_store_n(&numDirtyPageWrites, 0, __ATOMIC_RELAXED);}
 };
 
 
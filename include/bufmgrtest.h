@@ -0,0 +1,6 @@
+#ifndef BUFMGRTEST_H
+#define BUFMGRTEST_H
+
+int RunBufMgrTests();
+
+#endif
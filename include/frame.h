@@ -1,10 +1,29 @@
 #ifndef FRAME_H
 #define FRAME_H
 
+#include <pthread.h>
+
 #include "page.h"
 
 #define INVALID_FRAME -1
 
+// The buffer manager's own pins, which count apart from those of
+// the users of the page: one while the page is written out, and one
+// while a replacer holds the frame for another page (until StartRead)
+#define WRITE_PIN       0x100
+#define REPLACEMENT_PIN 0x10000
+
+//---------------------------------------------------------------
+// A frame of the buffer pool.
+//
+// Several threads use a frame at once, so pid, pinCount, dirty and
+// referenced are read and written atomically. A frame gets another
+// page only while the thread that fills it has it pinned and holds
+// the page table latches of the old and the new page (see BufMgr),
+// so whoever looks a page up and pins it under its latch keeps the
+// page in the frame until it unpins it.
+//---------------------------------------------------------------
+
 class Frame 
 {
 	private :
@@ -15,20 +34,42 @@ class Frame
 		int    dirty;
 		Bool referenced;
 
+		// Read of the page into the frame, by the thread that placed
+		// it there or the ReadAheadThread (see BufMgr::PrefetchPage)
+		Bool reading;
+		Bool readFailed;
+		Bool prefetched;     // not pinned by anyone but the read-ahead yet
+		pthread_mutex_t ioLock;
+		pthread_cond_t ioDone;
+
+		// Unpinned frames of the buffer manager, counted down when the
+		// pin count leaves 0 and up when it returns to 0
+		int *numOfUnpinnedFrames;
+		void CountPinned();
+		void CountUnpinned();
+
 	public :
 		
-		Frame();
+		Frame(int *numOfUnpinnedFrames);
 		~Frame();
 		void Pin();
+		void PinForWrite();
+		Bool PinForReplacement();      // TRUE if it was unpinned and is pinned now
 		void Unpin();
+		void UnpinForWrite();
+		void UnpinForReplacement();
+		Bool IsPinnedByBufMgr();       // for a write or a replacement
+		Bool IsPinnedByUsers();        // other than the buffer manager
+		Bool IsPinnedOnlyForReplacement();
+		int GetPinCount();
 		void EmptyIt();
 		void DirtyIt();
+		Bool CleanIt();                // TRUE if it was dirty
 		void SetPageID(PageID pid);
 		Bool IsDirty();
 		Bool IsValid();
-		Status Write();
+		Status Write();                // does not clear dirty, see CleanIt
 		Status Read(PageID pid);
-		Status Free();
 		Bool NotPinned();
 		Bool HasPageID(PageID pid);
 		PageID GetPageID();
@@ -38,6 +79,15 @@ class Frame
 		Bool IsReferenced();
 		Bool IsVictim();
 
+		void StartRead(PageID pid, Bool prefetch);
+		void EndRead(Status status);   // called by the reading thread
+		Status WaitForRead();          // OK if the page is in the frame
+		Bool ClaimPrefetch();          // TRUE on the first pin after a prefetch
+
+		// DB is not thread-safe: the buffer manager calls it under
+		// this lock
+		static void LockDB();
+		static void UnlockDB();
 };
 
 #endif
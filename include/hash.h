@@ -1,79 +1,77 @@
 #ifndef _HASH_H
 #define _HASH_H
 
+#include <pthread.h>
+
 #include "minirel.h"
 #include "frame.h"
 
-#define NUM_OF_BUCKETS 21
-#define HASH(k)  k % NUM_OF_BUCKETS
-
-	
-class Map
-{
-	friend class MapIterator;
-
-private :
-
-	int pid;
-	int frameNo;
-	class Map *next;
-	class Map *prev;
-
-public :
-	
-	Map(PageID p, int f);
-	~Map();
-	void AddBehind(Map *m);
-	void DeleteMe();
-	Bool HasPageID(PageID p);
-	int FrameNo();
-
-};
-
-
-class MapIterator
-{
-	Map *head;
-	Map *current;
-
-public :
-
-	MapIterator(Map *maps);
-	Map* operator() ();
+// Partitions of a HashTable, each with a latch of its own
+#define NUM_OF_PARTITIONS 16
+
+//---------------------------------------------------------------
+// Page table of the buffer manager: maps the PageID of every page
+// in the pool to the frame that holds it.
+//
+// Open addressing with linear probing over a single array, so a
+// lookup reads a few adjacent entries instead of walking a chain
+// of separately allocated nodes. The table starts with at least
+// twice as many entries as the pool has frames, which keeps the
+// load factor below one half, and doubles if it ever fills up
+// further. Delete moves the later entries of a probe sequence
+// back, so no tombstones are left behind.
+//
+// The pages are split by PageID over NUM_OF_PARTITIONS such arrays,
+// so that threads working on different pages seldom wait for the
+// same latch. Insert, Delete and LookUp do not latch anything: the
+// caller holds the latch of the page's partition (Lock), unless it
+// is the only thread using the table.
+//---------------------------------------------------------------
 
-};
-
-
-class Bucket
+class HashTable
 {
 private:
 
-	Map *maps;
+	struct Entry
+	{
+		PageID pid;   // INVALID_PAGE if the entry is free
+		int frameNo;
+	};
 
-public :
+	struct Partition
+	{
+		Entry *entries;
+		int numOfEntries;   // a power of two
+		int numOfPages;
+		int shift;          // 32 - log2(numOfEntries)
+		pthread_mutex_t latch;
+	};
 
-	Bucket();
-	~Bucket();
-	void Insert(PageID pid, int frameNo);
-	Status Delete(PageID pid);
-	int Find(PageID pid);
-	void EmptyIt();
-};
+	Partition partitions[NUM_OF_PARTITIONS];
 
-
-class HashTable
-{
-private:
-
-	Bucket buckets[NUM_OF_BUCKETS];
+	static int PartitionOf(PageID pid);
+	static int Home(Partition &partition, PageID pid);
+	static void Resize(Partition &partition, int newNumOfEntries);
+	static void Insert(Partition &partition, PageID pid, int frameNo);
 
 public :
 
+	HashTable(int numOfBuf);
+	~HashTable();
+
 	void Insert(PageID pid, int frameNo);
 	Status Delete(PageID pid);
 	int LookUp(PageID pid);
 	void EmptyIt();
+	int GetNumOfPages();   // in all partitions, read without latching
+
+	// Latch the partition of pid, or those of both pids in a fixed
+	// order (once if they share one); INVALID_PAGE is skipped
+	void Lock(PageID pid);
+	void Unlock(PageID pid);
+	void Lock(PageID pid1, PageID pid2);
+	void Unlock(PageID pid1, PageID pid2);
 };
 
 
-#endif
\ No newline at end of file
+#endif
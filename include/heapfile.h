@@ -14,6 +14,7 @@ class HeapPage;
 class HeapFile 
 {
 	friend class Scan;
+	friend class HeapPageScan;
 
 private :
 	
@@ -36,6 +37,8 @@ public:
 	
     int GetNumOfRecords();
     Status InsertRecord(char* recPtr, int recLen, RecordID& outRid); 
+    Status AppendRecords(const char* recs, int recLen, int count); // Store count consecutive records on new pages
+    Status AppendRecords(const char* recs, int recLen, int count, PageID& tailPid, PageID& tailDirPid); // First onto the page a previous append ended on
     Status DeleteRecord(const RecordID& rid); 
     Status UpdateRecord(const RecordID& rid, char* recPtr, int recLen);
     Status GetRecord(const RecordID& rid, char* recPtr, int& recLen); 
@@ -45,4 +48,35 @@ public:
 };
 
 
+// Collects fixed-length records in memory and stores them in a
+// HeapFile a few pages at a time through HeapFile::AppendRecords.
+// Records still buffered are written out by Flush() or on deletion.
+// Each Flush() goes on filling the page the previous one ended on.
+// Once a write fails, the records after it are dropped and Append()
+// and Flush() keep returning the failure, so a caller that checks
+// the final Flush() learns of any lost record.
+class HeapFileAppender
+{
+public:
+
+    HeapFileAppender(HeapFile* file, int recLen);
+    ~HeapFileAppender();
+
+    char* NextRecord(); // Space for the next record, valid until the next call
+    Status Append(const char* recPtr);
+    Status Flush();
+
+private:
+
+    HeapFile* file;
+    int   recLen;
+    char* recs;
+    int   numOfRecords;
+    int   capacity;
+    PageID tailPid;    // page the last Flush() ended on, INVALID_PAGE if none
+    PageID tailDirPid; // its directory page
+    Status status; // of the first failed write, OK if none
+};
+
+
 #endif
@@ -11,6 +11,9 @@ const int INVALID_SLOT =  -1;
 //
 const int HEAPPAGE_DATA_SIZE=(MAX_SPACE - 3*sizeof(PageID) - 6*sizeof(short));
 
+// Size of a slot directory entry (offset + length).
+const int SLOT_SIZE = 2*sizeof(short);
+
 class HeapPage {
 
 protected :
@@ -0,0 +1,79 @@
+#ifndef HEAPPAGESCAN_H
+#define HEAPPAGESCAN_H
+
+#include "minirel.h"
+#include "heapfile.h"
+#include "heappage.h"
+#include "bufmgr.h"
+#include "readahead.h"
+
+//---------------------------------------------------------------
+// Page-at-a-time scan of a HeapFile.
+//
+// Walks the data pages of a file in directory order and pins each
+// of them in the buffer pool, so that its records can be read in
+// place through HeapPage::ReturnRecord instead of being copied out
+// by Scan::GetNext. Pages without records are skipped.
+//
+// A scan is used through one of PinNextPage, GetNextRef and
+// GetNextPage only. A scan opened with ACCESS_SEQUENTIAL_ONCE reads
+// its data pages through a small BufferRing of its own. While a page
+// is being worked on, the next pages listed on the same directory
+// page are read ahead (see ReadAhead).
+//---------------------------------------------------------------
+
+class HeapPageScan
+{
+	public :
+
+		HeapPageScan(HeapFile* file, Status& status, AccessHint hint = ACCESS_NORMAL);
+		~HeapPageScan();
+
+		// Pin the next data page; the caller unpins it (clean) when it
+		// is done with the page. DONE after the last page.
+		Status PinNextPage(PageID& pid, HeapPage*& page);
+
+		// The next record, in place on its page. recPtr stays valid until
+		// the scan moves past that page, i.e. until a later call returns
+		// a record of another page or DONE, or the scan is deleted.
+		Status GetNextRef(RecordID& rid, const char*& recPtr, int& recLen);
+
+		// All records of the next page at once. Each array that is not NULL
+		// receives, per record, its RID, a pointer to it in place (valid
+		// until the next call) or the int attribute at keyOffset, and needs
+		// room for MaxRecordsPerPage(recLen) entries.
+		Status GetNextPage(int& numOfRecords, RecordID* rids, const char** recPtrs, int keyOffset = 0, int* keys = NULL);
+
+		// Most records of recLen bytes that a HeapPage can hold
+		static int MaxRecordsPerPage(int recLen);
+
+		// The hint for scans of a file of recLen byte records that is read
+		// over and over: ACCESS_SEQUENTIAL_ONCE if it spans more than a
+		// quarter of the buffer pool, so that it would flood the pool
+		static AccessHint ScanHint(HeapFile* file, int recLen);
+
+		// Pages that scans read ahead of the one they work on; 0 turns
+		// read-ahead off
+		static void SetReadAheadDepth(int depth);
+
+	private :
+
+		PageID nextDirPid;  // directory page after the current one
+		PageID* pids;       // data pages listed on the current directory page
+		int numOfPids;
+		int nextPid;        // next of them to pin
+		BufferRing* ring;   // NULL unless ACCESS_SEQUENTIAL_ONCE
+
+		ReadAhead* readAhead; // NULL until a page is read ahead
+		int nextToIssue;      // next of pids to read ahead
+		static int readAheadDepth;
+
+		// Page held pinned by GetNextRef and GetNextPage
+		PageID currPid;
+		HeapPage* currPage; // NULL if none
+		RecordID currRid;   // last record returned from it, slotNo INVALID_SLOT if none
+
+		Status ReadDirPage();
+};
+
+#endif
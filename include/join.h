@@ -1,10 +1,38 @@
 #ifndef JOIN_H
 #define JOIN_H
 
+#include <limits.h>
+
 #include "minirel.h"
 #include "bufmgr.h"
 #define MAX_REL_NAME_LENGTH 6 // MAX relation name length
 #define MAX_ATTR 10 // Max # of attributes
+#define MAX_INDEX_NAME_LENGTH 20 // Max join index name length
+
+class BTreeFile;
+
+// Which records a join returns. Set on the outer relation (R).
+enum JoinType
+{
+	INNER_JOIN,      // every matching pair of R and S records
+	SEMI_JOIN,       // every R record with a matching S record, once, without S attributes
+	ANTI_JOIN,       // every R record without a matching S record, without S attributes
+	LEFT_OUTER_JOIN  // INNER_JOIN, plus every R record without a match padded with NULL_ATTR
+};
+
+#define NULL_ATTR INT_MIN // value of the S attributes of unmatched R records in a LEFT_OUTER_JOIN
+
+// Type of the join attribute (see joinkey.h). Both relations must use the
+// same type and key length.
+enum JoinKeyType
+{
+	KEY_INT,       // int
+	KEY_INT64,     // long long
+	KEY_STRING,    // string of keyLen bytes, NUL terminated if shorter
+	KEY_COMPOSITE  // keyLen / sizeof(int) consecutive int attributes, compared in order
+};
+
+#define MAX_STRING_KEY_LEN 64 // longest KEY_STRING join attribute
 
 typedef struct JoinSpec {
 	char      relName[MAX_REL_NAME_LENGTH+1];// relation name
@@ -13,8 +41,19 @@ typedef struct JoinSpec {
 	int       recLen; // length of each record
 	int       joinAttr; // join attribute, = i means the ith attribute
 	int       offset; // offset: the offset of join attribute from the beginning of record
+	JoinKeyType keyType; // type of the join attribute
+	int       keyLen; // length of the join attribute in bytes
+	char      indexName[MAX_INDEX_NAME_LENGTH+1]; // persisted B+-tree on the join attribute, "" if none; change the relation through InsertIntoRelation/DeleteFromRelation, or the index is rebuilt on its next use
+	int       numOfOutAttr; // # of attributes copied into the join result, ALL_ATTR for the whole record
+	int       outAttr[MAX_ATTR]; // attributes copied into the join result, in result order
+	JoinType  joinType; // outer relation only: which records the join returns
+	AttrOperator joinOp; // outer relation only: join predicate R.joinAttr joinOp S.joinAttr (see KeysMatch)
+	int       bandWidth; // outer relation only: d of an opRANGE predicate, |R.joinAttr - S.joinAttr| <= d
+	bool      useBloomFilter; // outer relation only: skip R records whose key a Bloom filter over S rejects (equi-joins, see bloomfilter.h)
 } JoinSpec;
 
+#define ALL_ATTR -1 // numOfOutAttr: the join result holds the whole record
+
 #define ATTR_INT  attrInteger
 #define ATTR_STRING attrString
 
@@ -27,6 +66,20 @@ typedef struct JoinSpec {
 //#define NUM_OF_REC_IN_R 10000 // # of records in R
 //#define NUM_OF_REC_IN_S 2500 // # of records in S
 
+// How BlockNestedLoopJoin finds the block records matching an S record
+enum BlockProbe
+{
+	PROBE_SCAN, // compare with the join key of every record in the block
+	PROBE_HASH  // look up a hash table built over the block's join keys
+};
+
+// Where BlockNestedLoopJoin keeps the records of a block
+enum BlockStorage
+{
+	BLOCK_COPY,  // copied by a Scan into a block of B bytes
+	BLOCK_PINNED // read in place from the pages of R, pinned in the buffer pool
+};
+
 #define NUM_OF_ATTR_IN_R 6
 #define NUM_OF_ATTR_IN_S 4
 
@@ -34,14 +87,61 @@ typedef struct JoinSpec {
 // You need to allocate space for newRecord before calling this function.
 void MakeNewRecord(char *newRecord, char *r, char *s, int recLenR, int recLenS);
 
+// Make a new Record holding the output attributes (see JoinSpec::outAttr) of
+// r and s, and the length of such records. Only r is used by semi and anti
+// joins; s is NULL for an unmatched r of a left outer join.
+void MakeJoinedRecord(char *newRecord, const char *r, const char *s, const JoinSpec &specOfR, const JoinSpec &specOfS);
+int JoinedRecLen(const JoinSpec &specOfR, const JoinSpec &specOfS);
+
+// Whether the join attributes of specOfR and specOfS can be joined with the
+// predicate of specOfR; prints the reason and returns false if not.
+bool CheckJoinKeys(const JoinSpec &specOfR, const JoinSpec &specOfS);
+
+// The interval of S keys that can match the R key keyR, and of R keys that can
+// match the S key keyS, under the join predicate of specOfR. The bounds are
+// inclusive; false is returned if no key matches. Every key of the interval
+// matches, except for aopNE, whose interval is all keys. KEY_INT keys only.
+bool MatchingKeysOfS(int keyR, const JoinSpec &specOfR, int &lowS, int &highS);
+bool MatchingKeysOfR(int keyS, const JoinSpec &specOfR, int &lowR, int &highR);
+
 HeapFile* TupleNestedLoopJoin(JoinSpec, JoinSpec);
 
 HeapFile* BlockNestedLoopJoin(JoinSpec, JoinSpec);
 HeapFile* BlockNestedLoopJoin(JoinSpec, JoinSpec, int); // Explicitly specified buffer size
+HeapFile* BlockNestedLoopJoin(JoinSpec, JoinSpec, int, BlockProbe); // ... and probing method
+HeapFile* BlockNestedLoopJoin(JoinSpec, JoinSpec, int, BlockProbe, BlockStorage); // ... and block storage
 
 HeapFile* IndexNestedLoopJoin(JoinSpec, JoinSpec);
+HeapFile* IndexNestedLoopJoin(JoinSpec, JoinSpec, int); // Batched probing, batches of the given size
+
+HeapFile* HashJoin(JoinSpec, JoinSpec);
+HeapFile* HashJoin(JoinSpec, JoinSpec, int); // Explicitly specified buffer size
+
+HeapFile* SortMergeJoin(JoinSpec, JoinSpec);
+
+// Join algorithms
+enum JoinAlgorithm
+{
+	TUPLE_NESTED_LOOP,
+	BLOCK_NESTED_LOOP,
+	INDEX_NESTED_LOOP,
+	HASH,
+	SORT_MERGE,
+	COST_BASED // the one with the smallest estimated cost (see Join)
+};
+
+HeapFile* Join(JoinSpec, JoinSpec); // Run the algorithm chosen by ChooseJoinAlgorithm
+JoinAlgorithm ChooseJoinAlgorithm(JoinSpec, JoinSpec, double& cost); // Cheapest algorithm and its estimated page I/Os
 
 
 HeapFile *SortFile(HeapFile *S, int len, int offset);
+
+// Join indexes (see joinindex.cpp)
+BTreeFile* BuildJoinIndex(JoinSpec spec, const char* indexName); // Build a new index under the given name
+BTreeFile* OpenJoinIndex(JoinSpec spec); // Open spec.indexName, building it on first use
+Status InsertIntoRelation(JoinSpec spec, char* recPtr, RecordID& outRid); // Insert, maintaining the join index
+Status DeleteFromRelation(JoinSpec spec, const RecordID& rid); // Delete, maintaining the join index
+int IndexKeyLen(const JoinSpec &spec); // Length of the join index keys (KEY_INT and KEY_STRING keys)
+void MakeIndexKey(char* key, const char* rec, const JoinSpec &spec); // Join index key of the record rec
 #endif
 
@@ -0,0 +1,24 @@
+#ifndef JOINHASH_H
+#define JOINHASH_H
+
+// Hash functions on integer join keys. The two are independent of
+// each other, so a key space split with one of them can be hashed
+// again with the other without every key falling into one bucket.
+
+// Multiplicative (Fibonacci) hash, used to pick a partition
+static inline unsigned int PartitionHash(int key)
+{
+	return (unsigned int)key * 2654435761u;
+}
+
+// Avalanching hash, used for in-memory hash tables
+static inline unsigned int BucketHash(int key)
+{
+	unsigned int h = (unsigned int)key;
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	return h;
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef JOINKEY_H
+#define JOINKEY_H
+
+#include <string.h>
+
+#include "join.h"
+
+//---------------------------------------------------------------
+// Join key types (see JoinSpec::keyType).
+//
+// The join kernels are templates over one of the key classes
+// below, so that every key type gets its own copy of the inner
+// loops and the int case compiles down to plain int compares. A
+// key class provides
+//   Value                     - the key as the kernels hold it: the
+//                               key itself, or a pointer into the
+//                               record it was read from
+//   Load(keyPtr, keyLen)      - the key stored at keyPtr
+//   Equal(a, b, keyLen)
+//   Compare(a, b, keyLen)     - < 0, 0 or > 0
+//   Fold(a, keyLen)           - the key folded into an int; equal
+//                               keys fold into equal ints, which
+//                               PartitionHash and BucketHash hash
+//   WithinBand(r, s, d)       - |r - s| <= d, for numeric keys only
+//---------------------------------------------------------------
+
+struct IntJoinKey
+{
+	typedef int Value;
+
+	static const bool numeric = true;
+
+	static inline Value Load(const char* keyPtr, int) { return *(const int*)keyPtr; }
+	static inline bool Equal(Value a, Value b, int) { return a == b; }
+	static inline int Compare(Value a, Value b, int) { return (a > b) - (a < b); }
+	static inline int Fold(Value a, int) { return a; }
+
+	static inline bool WithinBand(Value r, Value s, int d)
+	{
+		return (long long)r >= (long long)s - d && (long long)r <= (long long)s + d;
+	}
+};
+
+struct Int64JoinKey
+{
+	typedef long long Value;
+
+	static const bool numeric = true;
+
+	static inline Value Load(const char* keyPtr, int)
+	{
+		Value key;
+		memcpy(&key, keyPtr, sizeof(Value)); // records only align ints
+		return key;
+	}
+	static inline bool Equal(Value a, Value b, int) { return a == b; }
+	static inline int Compare(Value a, Value b, int) { return (a > b) - (a < b); }
+	static inline int Fold(Value a, int) { return (int)(a ^ (a >> 32)); }
+
+	static inline bool WithinBand(Value r, Value s, int d)
+	{
+		// The distance is computed unsigned, where it cannot overflow
+		unsigned long long distance = (r >= s) ? (unsigned long long)r - (unsigned long long)s : (unsigned long long)s - (unsigned long long)r;
+		return d >= 0 && distance <= (unsigned long long)d;
+	}
+};
+
+// Strings of keyLen bytes; a string shorter than keyLen ends with a NUL
+struct StringJoinKey
+{
+	typedef const char* Value;
+
+	static const bool numeric = false;
+
+	static inline Value Load(const char* keyPtr, int) { return keyPtr; }
+	static inline bool Equal(Value a, Value b, int keyLen) { return 0 == strncmp(a, b, keyLen); }
+	static inline int Compare(Value a, Value b, int keyLen) { return strncmp(a, b, keyLen); }
+
+	static inline int Fold(Value a, int keyLen)
+	{
+		// FNV-1a over the characters up to the NUL
+		unsigned int h = 2166136261u;
+		for (int i = 0; i < keyLen && '\0' != a[i]; i++)
+		{
+			h = (h ^ (unsigned char)a[i]) * 16777619u;
+		}
+		return (int)h;
+	}
+
+	static inline bool WithinBand(Value, Value, int) { return false; }
+};
+
+// keyLen / sizeof(int) consecutive int attributes, ordered by the
+// first attribute, then the second, and so on
+struct CompositeJoinKey
+{
+	typedef const int* Value;
+
+	static const bool numeric = false;
+
+	static inline Value Load(const char* keyPtr, int) { return (const int*)keyPtr; }
+	static inline bool Equal(Value a, Value b, int keyLen) { return 0 == memcmp(a, b, keyLen); }
+
+	static inline int Compare(Value a, Value b, int keyLen)
+	{
+		for (int i = 0; i < keyLen / (int)sizeof(int); i++)
+		{
+			if (a[i] != b[i])
+			{
+				return (a[i] > b[i]) ? 1 : -1;
+			}
+		}
+		return 0;
+	}
+
+	static inline int Fold(Value a, int keyLen)
+	{
+		unsigned int h = 0;
+		for (int i = 0; i < keyLen / (int)sizeof(int); i++)
+		{
+			h = h * 31u + (unsigned int)a[i];
+		}
+		return (int)h;
+	}
+
+	static inline bool WithinBand(Value, Value, int) { return false; }
+};
+
+
+// Whether the keys of an R and an S record satisfy the join predicate of
+// specOfR. aopEQ, aopNE, aopLT, aopLE, aopGT, aopGE compare R's key with
+// S's key; opRANGE is the band predicate S - bandWidth <= R <= S + bandWidth.
+template <class Key>
+inline bool KeysMatch(typename Key::Value keyR, typename Key::Value keyS, const JoinSpec &specOfR)
+{
+	int keyLen = specOfR.keyLen;
+
+	switch (specOfR.joinOp)
+	{
+		case aopEQ:   return Key::Equal(keyR, keyS, keyLen);
+		case aopNE:   return !Key::Equal(keyR, keyS, keyLen);
+		case aopLT:   return Key::Compare(keyR, keyS, keyLen) < 0;
+		case aopLE:   return Key::Compare(keyR, keyS, keyLen) <= 0;
+		case aopGT:   return Key::Compare(keyR, keyS, keyLen) > 0;
+		case aopGE:   return Key::Compare(keyR, keyS, keyLen) >= 0;
+		case opRANGE: return Key::WithinBand(keyR, keyS, specOfR.bandWidth);
+		default:      return false;
+	}
+}
+
+inline bool JoinKeysMatch(int keyR, int keyS, const JoinSpec &specOfR)
+{
+	return KeysMatch<IntJoinKey>(keyR, keyS, specOfR);
+}
+
+#endif
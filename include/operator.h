@@ -0,0 +1,235 @@
+#ifndef OPERATOR_H
+#define OPERATOR_H
+
+#include "minirel.h"
+#include "heapfile.h"
+#include "scan.h"
+#include "join.h"
+
+class BTreeFile;
+class IndexFileScan;
+class HeapPageScan;
+
+//---------------------------------------------------------------
+// Pipelined (open/next/close) query operators.
+//
+// Every operator produces fixed-length records of RecLen() bytes.
+// Open() (re)starts the operator, GetNext() copies the next record
+// into recPtr and returns OK, DONE once the operator has no more
+// records, or FAIL if a record cannot be produced, and Close()
+// releases everything Open() acquired.
+// Operators are composed by passing child operators to the
+// constructor; a parent opens, drives and closes its children, so
+// records stream between operators instead of going through
+// intermediate HeapFiles.
+//
+// The inner relation of the nested loop joins is rescanned, so it
+// is given as a JoinSpec rather than as an operator.
+// The join operators compute inner joins of KEY_INT join attributes
+// only (JoinSpec::joinType must be INNER_JOIN).
+//---------------------------------------------------------------
+
+class Operator
+{
+	public :
+
+		virtual ~Operator() {}
+
+		virtual Status Open() = 0;
+		virtual Status GetNext(char* recPtr) = 0;
+		virtual void Close() = 0;
+
+		int RecLen() { return recLen; }
+
+	protected :
+
+		int recLen; // length of the records produced
+};
+
+
+// Sequential scan of a HeapFile
+class HeapScanOperator : public Operator
+{
+	public :
+
+		HeapScanOperator(HeapFile* file, int recLen);
+		~HeapScanOperator();
+
+		Status Open();
+		Status GetNext(char* recPtr);
+		void Close();
+
+	private :
+
+		HeapFile* file;
+		Scan* scan;
+};
+
+
+// Tuple nested loop join of the records of outer with relation S
+class TupleNestedLoopJoinOperator : public Operator
+{
+	public :
+
+		TupleNestedLoopJoinOperator(Operator* outer, JoinSpec specOfR, JoinSpec specOfS);
+		~TupleNestedLoopJoinOperator();
+
+		Status Open();
+		Status GetNext(char* recPtr);
+		void Close();
+
+	private :
+
+		Operator* outer;
+		JoinSpec specOfR, specOfS;
+
+		char* recR;
+		const char* recS;      // in place on its page of S
+		HeapPageScan* scanS;   // NULL when the next outer record has to be fetched
+		AccessHint hintS;      // for the scans of S
+};
+
+
+// Block nested loop join of the records of outer with relation S,
+// using blocks of B bytes
+class BlockNestedLoopJoinOperator : public Operator
+{
+	public :
+
+		BlockNestedLoopJoinOperator(Operator* outer, JoinSpec specOfR, JoinSpec specOfS, int B);
+		~BlockNestedLoopJoinOperator();
+
+		Status Open();
+		Status GetNext(char* recPtr);
+		void Close();
+
+	private :
+
+		Operator* outer;
+		JoinSpec specOfR, specOfS;
+
+		int recordsPerBlock;
+		char* recBlockR;
+		int numOfRecordsInBlock;
+		bool lastBlock;
+
+		const char* recS;     // in place on its page of S
+		HeapPageScan* scanS;  // NULL when the next block has to be filled
+		AccessHint hintS;     // for the scans of S
+		int nextRecordIndex;  // next block record to compare with recS, -1 if recS is not valid
+};
+
+
+// Index nested loop join of the records of outer with relation S,
+// probing the join index of S (see OpenJoinIndex)
+class IndexNestedLoopJoinOperator : public Operator
+{
+	public :
+
+		IndexNestedLoopJoinOperator(Operator* outer, JoinSpec specOfR, JoinSpec specOfS);
+		~IndexNestedLoopJoinOperator();
+
+		Status Open();
+		Status GetNext(char* recPtr);
+		void Close();
+
+	private :
+
+		Operator* outer;
+		JoinSpec specOfR, specOfS;
+
+		BTreeFile* bTree;
+		bool temporaryIndex;
+		IndexFileScan* bTreeScan; // NULL when the next outer record has to be fetched
+
+		char* recR;
+		char* recS;
+};
+
+
+// Merge equi-join of two inputs that are sorted on their join attributes
+class SortMergeJoinOperator : public Operator
+{
+	public :
+
+		SortMergeJoinOperator(Operator* left, Operator* right, JoinSpec specOfR, JoinSpec specOfS);
+		~SortMergeJoinOperator();
+
+		Status Open();
+		Status GetNext(char* recPtr);
+		void Close();
+
+	private :
+
+		Operator* left;
+		Operator* right;
+		JoinSpec specOfR, specOfS;
+
+		char* recR;
+		char* recS;
+		bool moreR, moreS;
+
+		char* groupS;       // run of S records sharing the current key
+		int groupSize;
+		int groupCapacity;
+		int groupIndex;     // next group record to join with recR, -1 if not in a group
+};
+
+
+// External merge sort of the records of input on the attribute at
+// offset, an integer or (ATTR_STRING) a string of keyLen bytes, NUL
+// terminated if shorter. Open()
+// consumes the whole input; if it fits into the free buffer frames
+// it is sorted and returned from memory, otherwise it is written out
+// as sorted runs that are merged while GetNext() is called. Equal
+// keys keep their input order.
+class SortOperator : public Operator
+{
+	public :
+
+		SortOperator(Operator* input, int offset, AttrType keyType = ATTR_INT, int keyLen = sizeof(int));
+		~SortOperator();
+
+		Status Open();
+		Status GetNext(char* recPtr);
+		void Close();
+
+	private :
+
+		Operator* input;
+		int offset;
+		AttrType keyType;
+		int keyLen;         // string keys are compared up to keyLen bytes
+
+		// In-memory run (used when the whole input fits into one run)
+		char* recBuffer;
+		struct SortEntry* entries;
+		int numOfEntries;
+		int nextEntry;
+
+		// Final merge of the runs written to disk
+		HeapFile** runs;
+		int numOfRuns;
+		Scan** scans;
+		char* currentRecs;
+		int* keys;
+		int* heap;
+		int heapSize;
+		int mergeWidth;     // number of runs being merged
+
+		bool RunPrecedes(int runA, int runB);
+		void SiftDown(int parent);
+
+		Status GenerateRuns(int runSize);
+		Status MergeRuns(int firstRun, int numOfRunsToMerge, HeapFile* output);
+		Status OpenMerge(int firstRun, int numOfRunsToMerge);
+		Status NextMerged(char* recPtr);
+		void CloseMerge();
+};
+
+
+// Sinks: drive an operator from Open() to Close()
+HeapFile* Materialize(Operator* op);      // write all records into a new temporary HeapFile
+int CountRecords(Operator* op);           // count the records
+
+#endif
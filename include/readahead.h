@@ -0,0 +1,91 @@
+#ifndef READAHEAD_H
+#define READAHEAD_H
+
+#include <pthread.h>
+
+#include "minirel.h"
+#include "bufmgr.h"
+
+//---------------------------------------------------------------
+// Asynchronous read-ahead for a scan.
+//
+// The scan names the pages it is about to pin through Issue. A page
+// that is not in the pool gets a frame at once and is read into it
+// by the read-ahead thread of the buffer manager (see
+// BufMgr::PrefetchPage) while the scan works on earlier pages. The
+// read-ahead keeps such a frame pinned until the scan has pinned the
+// page itself and calls Release, or until the ReadAhead is deleted.
+// At most depth pages are pending.
+//---------------------------------------------------------------
+
+class ReadAhead
+{
+	public :
+
+		ReadAhead(int depth, BufferRing* ring);   // ring may be NULL
+		~ReadAhead();
+
+		// Start reading the page unless it is in the pool, depth pages
+		// are pending already, or no frame can be spared for it
+		void Issue(PageID pid);
+
+		// The scan has pinned the page; pages are released in the order
+		// they were issued
+		void Release(PageID pid);
+
+	private :
+
+		int depth;
+		BufferRing* ring;
+
+		// Pages issued and not released yet, a ring of depth entries,
+		// and the frames they are read into
+		PageID* pids;
+		Frame** frames;
+		long numOfIssued;
+		long numOfReleased;
+};
+
+
+//---------------------------------------------------------------
+// The read-ahead thread of a buffer manager.
+//
+// One thread, started on the first Submit, reads the pages of all
+// scans in the order they were submitted. It reads the database
+// file with pread through the descriptor of the buffer manager
+// (BufMgr::GetDBFile), not through DB, which keeps a file position
+// on its descriptor that the scans' threads move; page n of the
+// database is stored at n * MINIBASE_PAGESIZE.
+//---------------------------------------------------------------
+
+class ReadAheadThread
+{
+	public :
+
+		ReadAheadThread(int capacity);   // reads that can be queued
+		~ReadAheadThread();              // ends the queued reads first
+
+		// Read the page into the frame, which is marked as being read
+		// (Frame::StartRead), and call frame->EndRead
+		void Submit(PageID pid, Frame* frame);
+
+	private :
+
+		// Reads submitted and not done yet, a ring of capacity entries
+		int capacity;
+		PageID* pids;
+		Frame** frames;
+		long numOfSubmitted;
+		long numOfRead;
+
+		bool started;
+		bool stop;
+		pthread_t thread;
+		pthread_mutex_t lock;
+		pthread_cond_t submitted;
+
+		static void* Run(void* readAheadThread);
+		static Status Read(PageID pid, Frame* frame);
+};
+
+#endif
@@ -3,6 +3,9 @@
 
 
 #include "join.h"
+
+class Operator;
+
 typedef struct Employee {
 	int id;
 	int age;
@@ -44,6 +47,7 @@ HeapFile *SortFile(HeapFile *S, int len, int offset);
 // Sort a relation stored in HeapFile S, len is the length of record, offset is the offset
 // of sort key attribute from the beginning of record, i.e. recptr+offset point to the sort key
 void PrintResult(HeapFile *RS, char *name, bool printToScreen = true); // Print the result of Joined relation RS to file whose filename is name
+void PrintResult(Operator *op, char *name, bool printToScreen = true); // Same, for the joined records an operator produces
 void PrintR (HeapFile *R, char *name);
 void PrintS (HeapFile *S, char *name);
 #endif
@@ -1,28 +1,246 @@
+#ifndef REPLACER_H
+#define REPLACER_H
+
+#include <pthread.h>
+
 #include "frame.h"
 #include "hash.h"
 
-class Replacer 
+//---------------------------------------------------------------
+// Replacement policies of the buffer manager.
+//
+// BufMgr asks PickVictim for the frame to load a missing page into
+// and reports what happens to the frames through the hooks below,
+// which policies that keep their own access history override.
+// Every policy picks empty frames before it evicts a page.
+//
+// Any thread may call a replacer. Policies with lists of frames
+// keep them under latch; the victim is pinned for the caller
+// (Frame::PinForReplacement) before anyone else can pick or pin it.
+//---------------------------------------------------------------
+
+class Replacer
 {
 	public :
 
 		Replacer();
-		~Replacer();
+		virtual ~Replacer();
 
+		// The frame to load the next page into, pinned for replacement,
+		// or INVALID_FRAME if every frame is pinned. A page in it
+		// counts as evicted.
 		virtual int PickVictim() = 0;
+
+		// A page in the pool was pinned again
+		virtual void AccessFrame(int frameNo);
+
+		// A page was read into (or created in) the frame
+		virtual void LoadFrame(int frameNo);
+
+		// The frame was emptied without an eviction, e.g. by FreePage
+		virtual void FreeFrame(int frameNo);
+
+		// The victim keeps its page after all, as another thread
+		// pinned that page before it could be replaced
+		virtual void ReturnFrame(int frameNo);
+
+		// Up to max unpinned frames whose pages PickVictim is going to
+		// evict next, about in that order, without evicting them (see
+		// BufMgr::CleanAhead). Returns how many it wrote to frameNos.
+		virtual int UpcomingVictims(int *frameNos, int max) = 0;
+
+		// The policy named by policy ("Clock", "LRU-K", "LRU-<k>", "2Q"
+		// or "ARC", in any case; Clock if NULL or empty), or NULL if
+		// there is no such policy
+		static Replacer* Create(const char* policy, int bufSize, Frame **frames, HashTable *hashTable);
+
+	protected :
+
+		pthread_mutex_t latch;
 };
 
 class Clock : public Replacer
 {
 	private :
-		
-		int current;
+
+		unsigned int current;   // advanced atomically, modulo numOfBuf
 		int numOfBuf;
 		Frame **frames;
 		HashTable *hashTable;
 
 	public :
-		
+
 		Clock( int bufSize, Frame **frames, HashTable *hashTable );
 		~Clock();
 		int PickVictim();
+		int UpcomingVictims(int *frameNos, int max);
+};
+
+
+// Doubly linked lists threaded through arrays indexed by node
+// number, so that moving a node between lists allocates nothing.
+// A node is in at most one list at a time; the front of a list is
+// its most recently used end.
+class LinkedLists
+{
+	private :
+
+		int *next;
+		int *prev;
+		int *listOf;
+		int *heads;
+		int *tails;
+		int *sizes;
+
+	public :
+
+		LinkedLists( int numOfNodes, int numOfLists );
+		~LinkedLists();
+		void PushFront(int list, int node);
+		void PushBack(int list, int node);
+		void Remove(int node);              // no-op if in no list
+		int Front(int list);                // -1 if empty
+		int Back(int list);                 // -1 if empty
+		int Prev(int node);                 // towards the front, -1 at it
+		int Size(int list);
+		int ListOf(int node);               // -1 if in no list
+};
+
+
+// Page IDs of recently evicted pages ("ghosts"), in LRU lists that
+// can be searched by PageID
+class GhostLists
+{
+	private :
+
+		LinkedLists lists;   // plus a last list of unused nodes
+		PageID *pids;
+		HashTable nodeOf;
+		int numOfLists;
+
+	public :
+
+		GhostLists( int capacity, int numOfLists );
+		~GhostLists();
+
+		// Remember pid at the front of list; when all nodes are in use,
+		// the oldest ghost of the longest list is forgotten first
+		void Add(int list, PageID pid);
+		int Find(PageID pid);               // its list, or -1
+		void Remove(PageID pid);
+		void RemoveOldest(int list);
+		int Size(int list);
+};
+
+
+// LRU-K (O'Neil, O'Neil and Weikum): evicts the unpinned page whose
+// K-th most recent reference lies furthest back. Pages referenced
+// fewer than K times go first, least recently used first. The
+// references of evicted pages are retained for as many pages as the
+// pool has frames, so that a page read again soon is not treated as
+// new.
+class LRUK : public Replacer
+{
+	private :
+
+		int k;
+		int numOfBuf;
+		Frame **frames;
+		long time;
+		long *history;         // k reference times per frame, latest first, 0 if none
+
+		// Retained history of evicted pages, a ring of numOfBuf entries
+		PageID *retainedPids;
+		long *retainedHistory;
+		int nextRetained;
+		HashTable retainedSlot;
+
+		// Binary heap of the frames not handed out by PickVictim, the
+		// next victim first, and the position of each frame in it
+		int *heap;
+		int *heapPos;          // -1 if not in the heap
+		int heapSize;
+		int *passedOver;       // pinned frames popped by PickVictim
+
+		void Reference(int frameNo);
+		bool Precedes(int frameA, int frameB);
+		void SiftUp(int pos);
+		void SiftDown(int pos);
+		void Reposition(int frameNo);
+
+	public :
+
+		LRUK( int bufSize, Frame **frames, int k );
+		~LRUK();
+		int PickVictim();
+		int UpcomingVictims(int *frameNos, int max);
+		void AccessFrame(int frameNo);
+		void LoadFrame(int frameNo);
+		void FreeFrame(int frameNo);
+		void ReturnFrame(int frameNo);
 };
+
+
+// 2Q (Johnson and Shasha): pages read for the first time enter the
+// FIFO A1in, a quarter of the pool. Only pages referenced again
+// after they left it, which A1out remembers for half a pool's worth
+// of pages, are promoted to the LRU list Am. A sequential scan
+// therefore only cycles through A1in.
+class TwoQ : public Replacer
+{
+	private :
+
+		enum { A1IN, AM, FREE, NUM_OF_LISTS };
+
+		int numOfBuf;
+		Frame **frames;
+		int maxA1in;
+		LinkedLists lists;
+		GhostLists a1out;
+
+	public :
+
+		TwoQ( int bufSize, Frame **frames );
+		~TwoQ();
+		int PickVictim();
+		int UpcomingVictims(int *frameNos, int max);
+		void AccessFrame(int frameNo);
+		void LoadFrame(int frameNo);
+		void FreeFrame(int frameNo);
+		void ReturnFrame(int frameNo);
+};
+
+
+// ARC (Megiddo and Modha): T1 holds pages referenced once recently,
+// T2 pages referenced at least twice, and the ghost lists B1 and B2
+// the pages last evicted from each. A re-read of a ghost moves the
+// target size of T1 towards the list that would have kept the page.
+// BufMgr asks for the victim before it names the missing page, so
+// the target adapts when the page is loaded instead of just before
+// the victim is picked.
+class ARC : public Replacer
+{
+	private :
+
+		enum { T1, T2, FREE, NUM_OF_LISTS };
+		enum { B1, B2, NUM_OF_GHOST_LISTS };
+
+		int numOfBuf;
+		Frame **frames;
+		int target;          // of the size of T1
+		LinkedLists lists;
+		GhostLists ghosts;
+
+	public :
+
+		ARC( int bufSize, Frame **frames );
+		~ARC();
+		int PickVictim();
+		int UpcomingVictims(int *frameNos, int max);
+		void AccessFrame(int frameNo);
+		void LoadFrame(int frameNo);
+		void FreeFrame(int frameNo);
+		void ReturnFrame(int frameNo);
+};
+
+#endif
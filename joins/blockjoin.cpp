@@ -1,12 +1,356 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+
+// The AVX2 comparison of int keys is compiled for x86 whatever the
+// target flags, and used if the CPU running the join has AVX2
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define AVX2_DISPATCH
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "../include/minirel.h"
 #include "../include/heapfile.h"
 #include "../include/scan.h"
 #include "../include/join.h"
+#include "../include/joinkey.h"
 #include "../include/relation.h"
+#include "../include/joinhash.h"
+#include "../include/bloomfilter.h"
+#include "../include/heappagescan.h"
+
+// Number of block keys compared against a probe key per vector step
+#define AVX2_KEYS_PER_PROBE 16
+#define SSE2_KEYS_PER_PROBE 8
+
+#define KEY_BLOCK_ALIGNMENT 32
+
+
+//---------------------------------------------------------------
+// FindMatchingKeys
+//
+// Purpose : Find all positions in a contiguous, KEY_BLOCK_ALIGNMENT
+//           aligned array of block keys that are equal to probeKey.
+// Output  : matchIndexes - indexes of the matching keys, ascending.
+// Return  : Number of matches.
+//---------------------------------------------------------------
+
+template <class Key>
+static int FindMatchingKeys(const typename Key::Value* keys, int numOfKeys, typename Key::Value probeKey, int keyLen, int* matchIndexes)
+{
+	int numOfMatches = 0;
+
+	for (int i = 0; i < numOfKeys; i++)
+	{
+		if (Key::Equal(keys[i], probeKey, keyLen))
+		{
+			matchIndexes[numOfMatches++] = i;
+		}
+	}
+
+	return numOfMatches;
+}
+
+#if defined(AVX2_DISPATCH)
+// Compare the keys from i on AVX2_KEYS_PER_PROBE at a time, leaving
+// i at the remaining tail; returns the number of matches
+__attribute__((target("avx2")))
+static int FindMatchingIntKeysAVX2(const int* keys, int numOfKeys, int probeKey, int* matchIndexes, int& i)
+{
+	int numOfMatches = 0;
+
+	__m256i probe = _mm256_set1_epi32(probeKey);
+	for (; i + AVX2_KEYS_PER_PROBE <= numOfKeys; i += AVX2_KEYS_PER_PROBE)
+	{
+		__m256i low  = _mm256_cmpeq_epi32(_mm256_load_si256((const __m256i*)(keys + i)), probe);
+		__m256i high = _mm256_cmpeq_epi32(_mm256_load_si256((const __m256i*)(keys + i + 8)), probe);
+
+		unsigned int mask = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(low))
+			| ((unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(high)) << 8);
+
+		while (mask)
+		{
+			matchIndexes[numOfMatches++] = i + __builtin_ctz(mask);
+			mask &= mask - 1;
+		}
+	}
+
+	return numOfMatches;
+}
+#endif
+
+// Int keys are compared 16 at a time with AVX2 if the CPU has it,
+// then 8 at a time with SSE2, and the matches are read off the
+// comparison bitmask; the remaining tail is compared one key at a
+// time.
+template <>
+int FindMatchingKeys<IntJoinKey>(const int* keys, int numOfKeys, int probeKey, int, int* matchIndexes)
+{
+	int numOfMatches = 0;
+	int i = 0;
+
+#if defined(AVX2_DISPATCH)
+	static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+	if (hasAVX2)
+	{
+		numOfMatches = FindMatchingIntKeysAVX2(keys, numOfKeys, probeKey, matchIndexes, i);
+	}
+#endif
+
+#if defined(__SSE2__)
+	__m128i probe = _mm_set1_epi32(probeKey);
+	for (; i + SSE2_KEYS_PER_PROBE <= numOfKeys; i += SSE2_KEYS_PER_PROBE)
+	{
+		__m128i low  = _mm_cmpeq_epi32(_mm_load_si128((const __m128i*)(keys + i)), probe);
+		__m128i high = _mm_cmpeq_epi32(_mm_load_si128((const __m128i*)(keys + i + 4)), probe);
+
+		unsigned int mask = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(low))
+			| ((unsigned int)_mm_movemask_ps(_mm_castsi128_ps(high)) << 4);
+
+		while (mask)
+		{
+			matchIndexes[numOfMatches++] = i + __builtin_ctz(mask);
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	for (; i < numOfKeys; i++)
+	{
+		if (keys[i] == probeKey)
+		{
+			matchIndexes[numOfMatches++] = i;
+		}
+	}
+
+	return numOfMatches;
+}
+
+
+//---------------------------------------------------------------
+// FindKeysMatchingPredicate
+//
+// Purpose : Same as FindMatchingKeys for the other join predicates
+//           of specOfR.
+//---------------------------------------------------------------
+
+template <class Key>
+static int FindKeysMatchingPredicate(const typename Key::Value* keys, int numOfKeys, typename Key::Value probeKey, const JoinSpec& specOfR, int* matchIndexes)
+{
+	int numOfMatches = 0;
+
+	for (int i = 0; i < numOfKeys; i++)
+	{
+		if (KeysMatch<Key>(keys[i], probeKey, specOfR))
+		{
+			matchIndexes[numOfMatches++] = i;
+		}
+	}
+
+	return numOfMatches;
+}
+
+// The int keys that satisfy the predicate with the S key probeKey
+// form an interval (aopNE aside), and each key is tested against
+// its bounds.
+template <>
+int FindKeysMatchingPredicate<IntJoinKey>(const int* keys, int numOfKeys, int probeKey, const JoinSpec& specOfR, int* matchIndexes)
+{
+	int numOfMatches = 0;
+
+	if (aopNE == specOfR.joinOp)
+	{
+		for (int i = 0; i < numOfKeys; i++)
+		{
+			if (keys[i] != probeKey)
+			{
+				matchIndexes[numOfMatches++] = i;
+			}
+		}
+		return numOfMatches;
+	}
+
+	int lowKey, highKey;
+	if (!MatchingKeysOfR(probeKey, specOfR, lowKey, highKey))
+	{
+		return 0;
+	}
+
+	for (int i = 0; i < numOfKeys; i++)
+	{
+		if (keys[i] >= lowKey && keys[i] <= highKey)
+		{
+			matchIndexes[numOfMatches++] = i;
+		}
+	}
+
+	return numOfMatches;
+}
+
+
+//---------------------------------------------------------------
+// Open-addressing hash table over the join keys of a block.
+//
+// Every distinct key occupies one slot (linear probing, load factor
+// at most 1/2); block records sharing a key are chained through
+// nextWithSameKey in ascending block order.
+//---------------------------------------------------------------
+
+template <class Key>
+struct BlockHashTable
+{
+	typedef typename Key::Value Value;
+
+	unsigned int mask;     // number of slots - 1 (a power of two)
+	Value* slotKeys;       // key held by each slot
+	int* slotHeads;        // first block record with that key, -1 if the slot is empty
+	int* nextWithSameKey;  // next block record with the same key, -1 at the end
+};
+
+template <class Key>
+static void BuildBlockHashTable(BlockHashTable<Key>& table, const typename Key::Value* keys, int numOfKeys, int keyLen)
+{
+	for (unsigned int slot = 0; slot <= table.mask; slot++)
+	{
+		table.slotHeads[slot] = -1;
+	}
+
+	// Insert backwards so that every chain ends up in ascending order
+	for (int i = numOfKeys - 1; i >= 0; i--)
+	{
+		unsigned int slot = BucketHash(Key::Fold(keys[i], keyLen)) & table.mask;
+		while (table.slotHeads[slot] != -1 && !Key::Equal(table.slotKeys[slot], keys[i], keyLen))
+		{
+			slot = (slot + 1) & table.mask;
+		}
+
+		table.slotKeys[slot] = keys[i];
+		table.nextWithSameKey[i] = table.slotHeads[slot];
+		table.slotHeads[slot] = i;
+	}
+}
+
+// Same output contract as FindMatchingKeys
+template <class Key>
+static int ProbeBlockHashTable(const BlockHashTable<Key>& table, typename Key::Value probeKey, int keyLen, int* matchIndexes)
+{
+	unsigned int slot = BucketHash(Key::Fold(probeKey, keyLen)) & table.mask;
+	while (table.slotHeads[slot] != -1)
+	{
+		if (Key::Equal(table.slotKeys[slot], probeKey, keyLen))
+		{
+			int numOfMatches = 0;
+			for (int i = table.slotHeads[slot]; i != -1; i = table.nextWithSameKey[i])
+			{
+				matchIndexes[numOfMatches++] = i;
+			}
+			return numOfMatches;
+		}
+
+		slot = (slot + 1) & table.mask;
+	}
+
+	return 0;
+}
+
+
+//---------------------------------------------------------------
+// Blocks of pinned pages (BLOCK_PINNED).
+//
+// Instead of copying R into a block of B bytes, the block is made
+// of the B / MINIBASE_PAGESIZE next pages of R, which stay pinned
+// in the buffer pool until S has been scanned for the block. The
+// block records are read in place and only pointers to them are
+// kept, so the join needs no memory of its own for the records.
+//---------------------------------------------------------------
+
+struct PinnedBlock
+{
+	HeapPageScan* pagesOfR;
+	PageID* pids;       // pages of the current block
+	int numOfPids;
+	int maxPids;        // pages per block
+	HeapPage* page;     // last page pinned, NULL once all its records are in the block
+	RecordID rid;       // last record of page put into the block
+	bool pageStarted;   // whether rid is valid
+};
+
+// Next record of R for the current block, or NULL if the block has
+// all its pages or R has no more records (then lastBlock is set;
+// status is FAIL if a page of R cannot be pinned)
+static char* NextPinnedRecord(PinnedBlock& block, bool& lastBlock, Status& status)
+{
+	while (true)
+	{
+		if (NULL != block.page)
+		{
+			Status status = block.pageStarted ? block.page->NextRecord(block.rid, block.rid) : block.page->FirstRecord(block.rid);
+			block.pageStarted = true;
+
+			if (OK == status)
+			{
+				char* recPtr;
+				int recLen;
+				block.page->ReturnRecord(block.rid, recPtr, recLen);
+				return recPtr;
+			}
+			block.page = NULL;
+		}
+
+		if (block.numOfPids == block.maxPids)
+		{
+			return NULL;
+		}
+
+		Status pinStatus = block.pagesOfR->PinNextPage(block.pids[block.numOfPids], block.page);
+		if (OK != pinStatus)
+		{
+			block.page = NULL;
+			lastBlock = true;
+			if (DONE != pinStatus)
+			{
+				status = FAIL;
+			}
+			return NULL;
+		}
+		block.numOfPids++;
+		block.pageStarted = false;
+	}
+}
+
+// Unpin the pages of the block once S has been probed with it. If
+// keepPage is set, the page records are being taken from, whose
+// later records go into the next block, stays pinned as the first
+// page of the next block.
+static void UnpinBlock(PinnedBlock& block, bool keepPage)
+{
+	bool keepLastPage = keepPage && NULL != block.page;
+	int numOfPidsToUnpin = keepLastPage ? block.numOfPids - 1 : block.numOfPids;
+
+	for (int i = 0; i < numOfPidsToUnpin; i++)
+	{
+		if (OK != MINIBASE_BM->UnpinPage(block.pids[i], CLEAN))
+		{
+			cerr << "ERROR: cannot unpin page " << block.pids[i] << " of the relation R.\n";
+		}
+	}
+
+	if (keepLastPage)
+	{
+		block.pids[0] = block.pids[block.numOfPids - 1];
+		block.numOfPids = 1;
+	}
+	else
+	{
+		block.numOfPids = 0;
+		block.page = NULL;
+		block.pageStarted = false;
+	}
+}
+
 
 HeapFile* BlockNestedLoopJoin(JoinSpec specOfR, JoinSpec specOfS)
 {
@@ -15,83 +359,316 @@ HeapFile* BlockNestedLoopJoin(JoinSpec specOfR, JoinSpec specOfS)
 
 HeapFile* BlockNestedLoopJoin(JoinSpec specOfR, JoinSpec specOfS, int B)
 {
+	return BlockNestedLoopJoin(specOfR, specOfS, B, PROBE_SCAN);
+}
+
+HeapFile* BlockNestedLoopJoin(JoinSpec specOfR, JoinSpec specOfS, int B, BlockProbe probe)
+{
+	return BlockNestedLoopJoin(specOfR, specOfS, B, probe, BLOCK_COPY);
+}
+
+// The join for join keys of type Key (see joinkey.h)
+template <class Key>
+static HeapFile* BlockNestedLoopJoin(JoinSpec specOfR, JoinSpec specOfS, int B, BlockProbe probe, BlockStorage storage)
+{
+	typedef typename Key::Value Value;
+
 	Status status = OK;
 
+	int recLenR = specOfR.recLen;
+	int recLenS = specOfS.recLen;
+	int recLenJoined = JoinedRecLen(specOfR, specOfS);
+
+	// A pinned block holds at least one page, a copied one B bytes
+	int maxPids = (B < MINIBASE_PAGESIZE) ? 1 : B / MINIBASE_PAGESIZE;
+	int recordsPerBlock = (BLOCK_PINNED == storage) ? maxPids * HeapPageScan::MaxRecordsPerPage(recLenR) : B / recLenR;
+	if (recordsPerBlock < 1)
+	{
+		cerr << "ERROR: the buffer is too small to hold a single record of R.\n";
+		return NULL;
+	}
+
 	// Create a HeapFile for join results
 	HeapFile* joinedFile = new HeapFile(NULL, status);
 	if (OK != status)
 	{
 		cerr << "ERROR: cannot create a file for the joined relation.\n";
+		delete joinedFile;
 		return NULL;
 	}
 
-	int recLenR = specOfR.recLen;
-	int recLenS = specOfS.recLen;
-	int recLenJoined = recLenR + recLenS;
+	JoinType joinType = specOfR.joinType;
+	int keyLen = specOfR.keyLen;
 
-	char* recBlockR = new char[B]; // Allocate memory for the block
-	char* recS = new char[recLenS];
-	char* recJoined = new char[recLenJoined];
+	// The hash table only finds equal keys
+	if (aopEQ != specOfR.joinOp)
+	{
+		probe = PROBE_SCAN;
+	}
 
-	RecordID ridR, ridS, ridJoined;
+	// The records of a page of S, read in place. S is scanned once per
+	// block; a large S is read through a ring of frames of its own
+	const char** recordsS = new const char*[HeapPageScan::MaxRecordsPerPage(recLenS)];
+	AccessHint hintS = HeapPageScan::ScanHint(specOfS.file, recLenS);
+	HeapFileAppender joinedRecords(joinedFile, recLenJoined);
 
-	Scan* scanR = specOfR.file->OpenScan(status);
-	if (OK != status)
+	// Bloom filter over the join keys of S (see bloomfilter.cpp)
+	BloomFilter* filter = UseBloomFilter(specOfR) ? BuildJoinKeyFilter(specOfS) : NULL;
+
+	RecordID ridR;
+
+	char* recBlockR = NULL;
+	Scan* scanR = NULL;
+	PinnedBlock pinnedBlock = { NULL, NULL, 0, 0, NULL, { INVALID_PAGE, INVALID_SLOT }, false };
+
+	if (BLOCK_PINNED == storage)
 	{
-		cerr << "ERROR: cannot open scan on the relation R heap file.\n";
-		return NULL;
+		pinnedBlock.pagesOfR = new HeapPageScan(specOfR.file, status);
+		if (OK != status)
+		{
+			cerr << "ERROR: cannot open page scan on the relation R heap file.\n";
+		}
+
+		// The pages of a block hold at most recordsPerBlock records
+		pinnedBlock.maxPids = maxPids;
+		pinnedBlock.pids = new PageID[pinnedBlock.maxPids];
 	}
+	else
+	{
+		scanR = specOfR.file->OpenScan(status);
+		if (OK != status)
+		{
+			cerr << "ERROR: cannot open scan on the relation R heap file.\n";
+			scanR = NULL;
+		}
 
-	const int recordsPerBlock = B / recLenR;
+		recBlockR = new char[B]; // Allocate memory for the block
+	}
 
-	bool lastBlock = false;
+	// The block records, in the block or in the pinned pages of R
+	char** recordsR = new char*[recordsPerBlock];
+
+	// Join keys of the block, extracted into a contiguous aligned array
+	char* keyBlockStorage = new char[recordsPerBlock * sizeof(Value) + KEY_BLOCK_ALIGNMENT];
+	Value* keyBlockR = (Value*)(((uintptr_t)keyBlockStorage + KEY_BLOCK_ALIGNMENT - 1) & ~(uintptr_t)(KEY_BLOCK_ALIGNMENT - 1));
+	int* matchIndexes = new int[recordsPerBlock];
+
+	// Block records that have found a match
+	bool* matchedR = new bool[recordsPerBlock];
+
+	// Hash table over the block keys (PROBE_HASH only)
+	BlockHashTable<Key> table = { 0, NULL, NULL, NULL };
+	if (PROBE_HASH == probe)
+	{
+		unsigned int numOfSlots = 1;
+		while (numOfSlots < 2 * (unsigned int)recordsPerBlock)
+		{
+			numOfSlots <<= 1;
+		}
+
+		table.mask = numOfSlots - 1;
+		table.slotKeys = new Value[numOfSlots];
+		table.slotHeads = new int[numOfSlots];
+		table.nextWithSameKey = new int[recordsPerBlock];
+	}
+
+	// Every failure leaves the loop with status FAIL, for the cleanup below
+	bool lastBlock = (OK != status);
 	while (!lastBlock)
 	{
 		// Fill the block
-		int i;
-		for (i = 0; i < recordsPerBlock; i++)
+		int i = 0;
+		while (i < recordsPerBlock)
 		{
-			if (OK != scanR->GetNext(ridR, recBlockR + i*recLenR, recLenR))
+			char* currentRecordPtr;
+			if (BLOCK_PINNED == storage)
 			{
-				lastBlock = true;
-				break;
+				currentRecordPtr = NextPinnedRecord(pinnedBlock, lastBlock, status);
+				if (NULL == currentRecordPtr)
+				{
+					break;
+				}
 			}
+			else
+			{
+				currentRecordPtr = recBlockR + i*recLenR;
+				Status scanStatus = scanR->GetNext(ridR, currentRecordPtr, recLenR);
+				if (OK != scanStatus)
+				{
+					lastBlock = true;
+					if (DONE != scanStatus)
+					{
+						status = FAIL;
+					}
+					break;
+				}
+			}
+
+			keyBlockR[i] = Key::Load(currentRecordPtr + specOfR.offset, keyLen);
+
+			// Records without a partner in S stay out of the block
+			if (NULL != filter && !filter->MayContain(Key::Fold(keyBlockR[i], keyLen)))
+			{
+				if (ANTI_JOIN == joinType || LEFT_OUTER_JOIN == joinType)
+				{
+					MakeJoinedRecord(joinedRecords.NextRecord(), currentRecordPtr, NULL, specOfR, specOfS);
+				}
+				continue;
+			}
+
+			recordsR[i++] = currentRecordPtr;
 		}
 		int lastRecordIndex = i;
 
-		Scan* scanS = specOfS.file->OpenScan(status);
 		if (OK != status)
 		{
-			cerr << "ERROR: cannot open scan on the relation S heap file.\n";
-			return NULL;
+			cerr << "ERROR: cannot read the relation R.\n";
+			break;
 		}
 
-		while (OK == scanS->GetNext(ridS, recS, recLenS))
+		if (0 == lastRecordIndex)
 		{
-			int* joinArgS = (int*)&recS[specOfS.offset];
+			UnpinBlock(pinnedBlock, true);
+			if (lastBlock)
+			{
+				break;
+			}
+			continue;
+		}
 
-			for (int currentRecordIndex = 0; currentRecordIndex < lastRecordIndex; currentRecordIndex++)
+		if (PROBE_HASH == probe)
+		{
+			BuildBlockHashTable(table, keyBlockR, lastRecordIndex, keyLen);
+		}
+
+		memset(matchedR, 0, lastRecordIndex * sizeof(bool));
+		int numOfMatchedR = 0;
+
+		HeapPageScan* scanS = new HeapPageScan(specOfS.file, status, hintS);
+		if (OK != status)
+		{
+			cerr << "ERROR: cannot open scan on the relation S heap file.\n";
+			delete scanS;
+			break;
+		}
+
+		// Probe the block with the records of S a page at a time
+		bool blockDone = false;
+		int numOfRecordsS;
+		Status scanStatus;
+		while (!blockDone && OK == (scanStatus = scanS->GetNextPage(numOfRecordsS, NULL, recordsS)))
+		{
+			for (int j = 0; j < numOfRecordsS && !blockDone; j++)
 			{
-				char* currentRecordPtr = recBlockR + (currentRecordIndex * recLenR);
-				int* joinArgR = (int*)(currentRecordPtr + specOfR.offset);
+				const char* recS = recordsS[j];
+				Value keyS = Key::Load(&recS[specOfS.offset], keyLen);
 
-				if (*joinArgR == *joinArgS)
+				int numOfMatches;
+				if (PROBE_HASH == probe)
 				{
-					MakeNewRecord(recJoined, currentRecordPtr, recS, recLenR, recLenS);
-					joinedFile->InsertRecord(recJoined, recLenJoined, ridJoined);
+					numOfMatches = ProbeBlockHashTable(table, keyS, keyLen, matchIndexes);
 				}
+				else if (aopEQ == specOfR.joinOp)
+				{
+					numOfMatches = FindMatchingKeys<Key>(keyBlockR, lastRecordIndex, keyS, keyLen, matchIndexes);
+				}
+				else
+				{
+					numOfMatches = FindKeysMatchingPredicate<Key>(keyBlockR, lastRecordIndex, keyS, specOfR, matchIndexes);
+				}
+				for (int match = 0; match < numOfMatches; match++)
+				{
+					int currentRecordIndex = matchIndexes[match];
+					char* currentRecordPtr = recordsR[currentRecordIndex];
+
+					if (INNER_JOIN == joinType || LEFT_OUTER_JOIN == joinType ||
+						(SEMI_JOIN == joinType && !matchedR[currentRecordIndex]))
+					{
+						MakeJoinedRecord(joinedRecords.NextRecord(), currentRecordPtr, recS, specOfR, specOfS);
+					}
+
+					if (!matchedR[currentRecordIndex])
+					{
+						matchedR[currentRecordIndex] = true;
+						numOfMatchedR++;
+					}
+				}
+
+				// A semi or anti join is done with the block once all of it has matched
+				blockDone = (SEMI_JOIN == joinType || ANTI_JOIN == joinType) && numOfMatchedR == lastRecordIndex;
 			}
 		}
 
 		delete scanS;
+
+		if (!blockDone && DONE != scanStatus)
+		{
+			cerr << "ERROR: cannot read the relation S.\n";
+			status = FAIL;
+			break;
+		}
+
+		if (ANTI_JOIN == joinType || LEFT_OUTER_JOIN == joinType)
+		{
+			for (i = 0; i < lastRecordIndex; i++)
+			{
+				if (!matchedR[i])
+				{
+					MakeJoinedRecord(joinedRecords.NextRecord(), recordsR[i], NULL, specOfR, specOfS);
+				}
+			}
+		}
+
+		UnpinBlock(pinnedBlock, true);
+	}
+
+	// Write out the buffered results
+	if (OK != joinedRecords.Flush())
+	{
+		cerr << "ERROR: cannot write the joined relation.\n";
+		status = FAIL;
 	}
 
 	// Release the allocated resources
+	UnpinBlock(pinnedBlock, false);
 	delete scanR;
+	delete pinnedBlock.pagesOfR;
 
 	delete[] recBlockR;
-	delete[] recS;
-	delete[] recJoined;
+	delete[] recordsR;
+	delete[] pinnedBlock.pids;
+	delete[] keyBlockStorage;
+	delete[] matchIndexes;
+	delete[] matchedR;
+	delete[] table.slotKeys;
+	delete[] table.slotHeads;
+	delete[] table.nextWithSameKey;
+	delete[] recordsS;
+	delete filter;
+
+	if (OK != status)
+	{
+		joinedFile->DeleteFile();
+		delete joinedFile;
+		return NULL;
+	}
 
 	return joinedFile;
 }
+
+
+HeapFile* BlockNestedLoopJoin(JoinSpec specOfR, JoinSpec specOfS, int B, BlockProbe probe, BlockStorage storage)
+{
+	if (!CheckJoinKeys(specOfR, specOfS))
+	{
+		return NULL;
+	}
+
+	switch (specOfR.keyType)
+	{
+		case KEY_INT64:     return BlockNestedLoopJoin<Int64JoinKey>(specOfR, specOfS, B, probe, storage);
+		case KEY_STRING:    return BlockNestedLoopJoin<StringJoinKey>(specOfR, specOfS, B, probe, storage);
+		case KEY_COMPOSITE: return BlockNestedLoopJoin<CompositeJoinKey>(specOfR, specOfS, B, probe, storage);
+		default:            return BlockNestedLoopJoin<IntJoinKey>(specOfR, specOfS, B, probe, storage);
+	}
+}
\ No newline at end of file
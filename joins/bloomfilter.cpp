@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/minirel.h"
+#include "../include/heapfile.h"
+#include "../include/scan.h"
+#include "../include/join.h"
+#include "../include/joinkey.h"
+#include "../include/bloomfilter.h"
+#include "../include/heappagescan.h"
+
+
+//---------------------------------------------------------------
+// Bloom filter pushdown.
+//
+// With JoinSpec::useBloomFilter set on R, the block, index and hash
+// joins first scan S once and build a Bloom filter over its join
+// keys. Every R record is looked up in the filter before it enters
+// a block, a batch or a partition, or before the index is probed
+// for it; a record the filter rejects has no partner in S, so it is
+// dropped (or returned as unmatched by anti and left outer joins)
+// right away. If S cannot be read in full, the join runs without a
+// filter, as one missing keys of S would reject matching R records.
+//---------------------------------------------------------------
+
+// Filter bits per key; with the rounding up to a power of two this
+// gives between 10 and 20 bits, i.e. 1% or fewer false positives
+#define BLOOM_BITS_PER_KEY 10
+
+#define BLOOM_MAX_HASHES 8
+
+
+BloomFilter::BloomFilter(int numOfKeys)
+{
+	unsigned int numOfBits = 64;
+	while (numOfBits < (unsigned int)numOfKeys * BLOOM_BITS_PER_KEY && numOfBits < (1u << 31))
+	{
+		numOfBits <<= 1;
+	}
+
+	mask = numOfBits - 1;
+	bits = new unsigned int[numOfBits / 32];
+	memset(bits, 0, (numOfBits / 32) * sizeof(unsigned int));
+
+	// k = (bits per key) * ln 2 minimises the false positive rate
+	numOfHashes = (numOfKeys > 0) ? (int)(0.69 * numOfBits / numOfKeys) : 1;
+	if (numOfHashes < 1)
+	{
+		numOfHashes = 1;
+	}
+	if (numOfHashes > BLOOM_MAX_HASHES)
+	{
+		numOfHashes = BLOOM_MAX_HASHES;
+	}
+}
+
+BloomFilter::~BloomFilter()
+{
+	delete[] bits;
+}
+
+void BloomFilter::Add(int foldedKey)
+{
+	unsigned int h1 = PartitionHash(foldedKey);
+	unsigned int h2 = BucketHash(foldedKey) | 1;
+
+	for (int i = 0; i < numOfHashes; i++)
+	{
+		unsigned int bit = (h1 + i * h2) & mask;
+		bits[bit >> 5] |= 1u << (bit & 31);
+	}
+}
+
+
+int FoldJoinKey(const char* rec, const JoinSpec& spec)
+{
+	const char* keyPtr = rec + spec.offset;
+
+	switch (spec.keyType)
+	{
+		case KEY_INT64:     return Int64JoinKey::Fold(Int64JoinKey::Load(keyPtr, spec.keyLen), spec.keyLen);
+		case KEY_STRING:    return StringJoinKey::Fold(StringJoinKey::Load(keyPtr, spec.keyLen), spec.keyLen);
+		case KEY_COMPOSITE: return CompositeJoinKey::Fold(CompositeJoinKey::Load(keyPtr, spec.keyLen), spec.keyLen);
+		default:            return IntJoinKey::Fold(IntJoinKey::Load(keyPtr, spec.keyLen), spec.keyLen);
+	}
+}
+
+
+//---------------------------------------------------------------
+// BuildJoinKeyFilter
+//
+// Purpose : Scan a relation and add the join key of every record
+//           to a Bloom filter sized from its cardinality.
+// Return  : The filter, or NULL if the relation cannot be read to
+//           the end.
+//---------------------------------------------------------------
+
+BloomFilter* BuildJoinKeyFilter(JoinSpec spec)
+{
+	Status status = OK;
+
+	HeapPageScan* scan = new HeapPageScan(spec.file, status);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot open scan on the relation " << spec.relName << " heap file.\n";
+		delete scan;
+		return NULL;
+	}
+
+	BloomFilter* filter = new BloomFilter(spec.file->GetNumOfRecords());
+
+	// Int keys fold into themselves and are gathered a page at a time
+	// straight from the records; other keys are folded record by record
+	int maxRecordsPerPage = HeapPageScan::MaxRecordsPerPage(spec.recLen);
+	const char** recs = new const char*[maxRecordsPerPage];
+	int* keys = new int[maxRecordsPerPage];
+	bool intKeys = (KEY_INT == spec.keyType);
+
+	int numOfRecords;
+	while (OK == (status = intKeys ? scan->GetNextPage(numOfRecords, NULL, NULL, spec.offset, keys) : scan->GetNextPage(numOfRecords, NULL, recs)))
+	{
+		for (int i = 0; i < numOfRecords; i++)
+		{
+			filter->Add(intKeys ? keys[i] : FoldJoinKey(recs[i], spec));
+		}
+	}
+
+	delete scan;
+	delete[] recs;
+	delete[] keys;
+
+	// A filter over part of the keys would drop R records with a partner
+	if (DONE != status)
+	{
+		cerr << "ERROR: cannot read the relation " << spec.relName << "; joining without a Bloom filter.\n";
+		delete filter;
+		return NULL;
+	}
+
+	return filter;
+}
+
+
+bool UseBloomFilter(const JoinSpec& specOfR)
+{
+	// Only equal keys fold into equal values
+	return specOfR.useBloomFilter && aopEQ == specOfR.joinOp;
+}
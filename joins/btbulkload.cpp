@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/minirel.h"
+#include "../include/bufmgr.h"
+#include "../include/btfile.h"
+#include "../include/btleaf.h"
+#include "../include/btindex.h"
+
+
+//---------------------------------------------------------------
+// Bottom-up bulk loading of a BTreeFile.
+//
+// The leaf level is written left to right from the sorted input,
+// each leaf being filled up to the requested fill factor and linked
+// to its neighbours. Every finished page contributes a <first key,
+// page id> entry to the level above, which is then packed in the
+// same way, until a level consists of a single page - the root.
+// Only one page is pinned at any time, and no page is ever split.
+//---------------------------------------------------------------
+
+
+struct LevelEntry
+{
+	KeyType key;  // smallest key stored under the page
+	PageID  pid;  // the page
+};
+
+struct Level
+{
+	LevelEntry* entries;
+	int         numOfEntries;
+	int         capacity;
+};
+
+static void AppendToLevel(Level& level, const void* key, int keyLength, PageID pid)
+{
+	if (level.numOfEntries == level.capacity)
+	{
+		int newCapacity = (level.capacity == 0) ? 64 : 2 * level.capacity;
+		LevelEntry* newEntries = new LevelEntry[newCapacity];
+		memcpy(newEntries, level.entries, level.numOfEntries * sizeof(LevelEntry));
+		delete[] level.entries;
+
+		level.entries = newEntries;
+		level.capacity = newCapacity;
+	}
+
+	LevelEntry& entry = level.entries[level.numOfEntries++];
+	memcpy(&entry.key, key, keyLength);
+	entry.pid = pid;
+}
+
+
+// Whether an entry of entryLength bytes still fits into a page that
+// holds numOfRecords entries, given the fill factor
+static bool EntryFits(SortedPage* page, int numOfRecords, int entryLength, float fillFactor)
+{
+	int available = page->AvailableSpace();
+	if (available < entryLength + SLOT_SIZE)
+	{
+		return false;
+	}
+
+	int used = HEAPPAGE_DATA_SIZE - available;
+	return numOfRecords == 0 || used + entryLength + SLOT_SIZE <= fillFactor * HEAPPAGE_DATA_SIZE;
+}
+
+
+// Allocate a page of the tree, left pinned
+static Status NewTreePage(PageID& pid, Page*& page)
+{
+	if (MINIBASE_BM->NewPage(pid, page) != OK)
+	{
+		cerr << "ERROR: cannot allocate a B+-tree page.\n";
+		return FAIL;
+	}
+	return OK;
+}
+
+
+// Unpin a page of the tree once it has been filled
+static Status UnpinTreePage(PageID pid)
+{
+	if (MINIBASE_BM->UnpinPage(pid, DIRTY) != OK)
+	{
+		cerr << "ERROR: cannot unpin B+-tree page " << pid << ".\n";
+		return FAIL;
+	}
+	return OK;
+}
+
+
+//---------------------------------------------------------------
+// BTreeFile::BulkLoad
+//
+// Purpose : Build the tree from the <key, rid> pairs of source.
+// Return  : OK, or FAIL if the tree is not empty, the input is not
+//           sorted or cannot be read, or a page cannot be allocated
+//           or filled. No page is left pinned on failure.
+//---------------------------------------------------------------
+
+Status BTreeFile::BulkLoad(BulkLoadSource *source, float fillFactor)
+{
+	if (header->root != INVALID_PAGE)
+	{
+		cerr << "ERROR: bulk loading is only supported on an empty B+-tree.\n";
+		return FAIL;
+	}
+
+	if (fillFactor <= 0.0 || fillFactor > 1.0)
+	{
+		cerr << "ERROR: the fill factor must be in (0, 1].\n";
+		return FAIL;
+	}
+
+	AttrType keyType = header->keyType;
+
+	Status status = OK;
+	Level level = { NULL, 0, 0 };
+
+	//
+	// Leaf level
+	//
+
+	KeyType key, previousKey;
+	RecordID dataRid, slotRid;
+
+	PageID leafPid = INVALID_PAGE;
+	BTLeafPage* leaf = NULL;
+	int numOfRecordsInLeaf = 0;
+
+	Status sourceStatus = DONE;
+	bool first = true;
+	while (status == OK && (sourceStatus = source->GetNext(dataRid, &key)) == OK)
+	{
+		if (!first && KeyCmp(&previousKey, &key, keyType) > 0)
+		{
+			cerr << "ERROR: bulk load input is not sorted on the key.\n";
+			status = FAIL;
+			break;
+		}
+
+		int keyLength = GetKeyLength(&key, keyType);
+		int entryLength = GetKeyDataLength(&key, keyType, LEAF_NODE);
+
+		if (leaf == NULL || !EntryFits(leaf, numOfRecordsInLeaf, entryLength, fillFactor))
+		{
+			// Start a new leaf and link it after the previous one
+			PageID newLeafPid;
+			Page* newPage;
+			if (NewTreePage(newLeafPid, newPage) != OK)
+			{
+				status = FAIL;
+				break;
+			}
+			BTLeafPage* newLeaf = (BTLeafPage*)newPage;
+			newLeaf->Init(newLeafPid);
+			newLeaf->SetType(LEAF_NODE);
+
+			PageID previousLeafPid = leafPid;
+			if (leaf != NULL)
+			{
+				leaf->SetNextPage(newLeafPid);
+				newLeaf->SetPrevPage(leafPid);
+			}
+
+			leafPid = newLeafPid;
+			leaf = newLeaf;
+			numOfRecordsInLeaf = 0;
+
+			AppendToLevel(level, &key, keyLength, leafPid);
+
+			if (previousLeafPid != INVALID_PAGE && UnpinTreePage(previousLeafPid) != OK)
+			{
+				status = FAIL;
+				break;
+			}
+		}
+
+		if (leaf->Insert(&key, keyType, dataRid, slotRid) != OK)
+		{
+			cerr << "ERROR: cannot insert into B+-tree leaf " << leafPid << ".\n";
+			status = FAIL;
+			break;
+		}
+		numOfRecordsInLeaf++;
+
+		memcpy(&previousKey, &key, keyLength);
+		first = false;
+	}
+
+	if (status == OK && sourceStatus != DONE)
+	{
+		cerr << "ERROR: cannot read the bulk load input.\n";
+		status = FAIL;
+	}
+
+	if (leaf != NULL && UnpinTreePage(leafPid) != OK)
+	{
+		status = FAIL;
+	}
+
+	if (status != OK)
+	{
+		delete[] level.entries;
+		return FAIL;
+	}
+
+	if (leaf == NULL)
+	{
+		// Empty input - the tree stays empty
+		return OK;
+	}
+
+	//
+	// Index levels, until a level fits into a single page
+	//
+
+	while (status == OK && level.numOfEntries > 1)
+	{
+		Level parentLevel = { NULL, 0, 0 };
+
+		PageID indexPid = INVALID_PAGE;
+		BTIndexPage* index = NULL;
+		int numOfRecordsInIndex = 0;
+
+		for (int i = 0; i < level.numOfEntries; i++)
+		{
+			LevelEntry& child = level.entries[i];
+			int entryLength = GetKeyDataLength(&child.key, keyType, INDEX_NODE);
+
+			if (index == NULL || !EntryFits(index, numOfRecordsInIndex, entryLength, fillFactor))
+			{
+				if (index != NULL)
+				{
+					index = NULL;
+					if (UnpinTreePage(indexPid) != OK)
+					{
+						status = FAIL;
+						break;
+					}
+				}
+
+				// The first child of an index page is its left link
+				Page* newPage;
+				if (NewTreePage(indexPid, newPage) != OK)
+				{
+					status = FAIL;
+					break;
+				}
+				index = (BTIndexPage*)newPage;
+				index->Init(indexPid);
+				index->SetType(INDEX_NODE);
+				index->SetLeftLink(child.pid);
+				numOfRecordsInIndex = 0;
+
+				AppendToLevel(parentLevel, &child.key, GetKeyLength(&child.key, keyType), indexPid);
+				continue;
+			}
+
+			RecordID entryRid;
+			if (index->Insert(&child.key, keyType, child.pid, entryRid) != OK)
+			{
+				cerr << "ERROR: cannot insert into B+-tree index page " << indexPid << ".\n";
+				status = FAIL;
+				break;
+			}
+			numOfRecordsInIndex++;
+		}
+
+		if (index != NULL && UnpinTreePage(indexPid) != OK)
+		{
+			status = FAIL;
+		}
+
+		delete[] level.entries;
+		level = parentLevel;
+	}
+
+	if (status != OK)
+	{
+		delete[] level.entries;
+		return FAIL;
+	}
+
+	PageID rootPid = level.entries[0].pid;
+	delete[] level.entries;
+
+	return UpdateHeader(rootPid);
+}
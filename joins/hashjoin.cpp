@@ -0,0 +1,451 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/minirel.h"
+#include "../include/heapfile.h"
+#include "../include/scan.h"
+#include "../include/join.h"
+#include "../include/relation.h"
+#include "../include/bufmgr.h"
+#include "../include/joinhash.h"
+#include "../include/joinkey.h"
+#include "../include/bloomfilter.h"
+#include "../include/heappagescan.h"
+
+
+//---------------------------------------------------------------
+// Grace hash join.
+//
+// Both relations are first partitioned on the join attribute into
+// temporary HeapFiles, so that the matching tuples of R and S end
+// up in partitions with the same index. Each partition of R is
+// then loaded into memory (at most B bytes at a time) together
+// with a chained hash table over its join keys, and the matching
+// partition of S is scanned once to probe it.
+//
+// If R fits into B bytes the partitioning phase is skipped and
+// the hash table is built directly over R.
+//
+// With a Bloom filter over S (JoinSpec::useBloomFilter), R records
+// without a partner in S are kept out of the partitions of inner
+// and semi joins and out of every hash table.
+//---------------------------------------------------------------
+
+
+//---------------------------------------------------------------
+// DeletePartitions
+//
+// Purpose : Delete the first numOfPartitions partition files.
+//---------------------------------------------------------------
+
+static void DeletePartitions(HeapFile** partitions, int numOfPartitions)
+{
+	for (int i = 0; i < numOfPartitions; i++)
+	{
+		partitions[i]->DeleteFile();
+		delete partitions[i];
+	}
+}
+
+
+//---------------------------------------------------------------
+// PartitionFile
+//
+// Purpose : Split a relation into numOfPartitions temporary
+//           HeapFiles on the hash of its join attribute, dropping
+//           the records whose key filter rejects (if not NULL).
+// Return  : OK on success, FAIL if a partition cannot be created
+//           or written or the relation cannot be read (partitions
+//           already created are deleted).
+//---------------------------------------------------------------
+
+template <class Key>
+static Status PartitionFile(JoinSpec spec, HeapFile** partitions, int numOfPartitions, const BloomFilter* filter)
+{
+	Status status = OK;
+
+	for (int i = 0; i < numOfPartitions; i++)
+	{
+		partitions[i] = new HeapFile(NULL, status);
+		if (OK != status)
+		{
+			cerr << "ERROR: cannot create a partition file for relation " << spec.relName << ".\n";
+			delete partitions[i];
+			DeletePartitions(partitions, i);
+			return FAIL;
+		}
+	}
+
+	Scan* scan = spec.file->OpenScan(status);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot open scan on the relation " << spec.relName << " heap file.\n";
+		delete scan;
+		DeletePartitions(partitions, numOfPartitions);
+		return FAIL;
+	}
+
+	int recLen = spec.recLen;
+	char* rec = new char[recLen];
+	RecordID rid, partitionRid;
+
+	Status scanStatus;
+	while (OK == (scanStatus = scan->GetNext(rid, rec, recLen)))
+	{
+		typename Key::Value key = Key::Load(&rec[spec.offset], spec.keyLen);
+		int foldedKey = Key::Fold(key, spec.keyLen);
+
+		if (NULL != filter && !filter->MayContain(foldedKey))
+		{
+			continue;
+		}
+
+		int partition = PartitionHash(foldedKey) % numOfPartitions;
+
+		if (OK != partitions[partition]->InsertRecord(rec, recLen, partitionRid))
+		{
+			cerr << "ERROR: cannot write a partition of relation " << spec.relName << ".\n";
+			status = FAIL;
+			break;
+		}
+	}
+
+	delete scan;
+	delete[] rec;
+
+	if (OK == status && DONE != scanStatus)
+	{
+		cerr << "ERROR: cannot read the relation " << spec.relName << ".\n";
+		status = FAIL;
+	}
+
+	if (OK != status)
+	{
+		DeletePartitions(partitions, numOfPartitions);
+		return FAIL;
+	}
+
+	return OK;
+}
+
+
+//---------------------------------------------------------------
+// JoinPartition
+//
+// Purpose : Join a single pair of (R, S) partitions. R is read in
+//           chunks of at most B bytes; for each chunk a hash table
+//           is built and the whole S partition is probed against it.
+//           R records whose key filter (if not NULL) rejects are
+//           left out of the chunks.
+// Return  : OK on success, FAIL if a partition cannot be read or
+//           the result cannot be written.
+//---------------------------------------------------------------
+
+template <class Key>
+static Status JoinPartition(HeapFile* fileR, HeapFile* fileS, JoinSpec specOfR, JoinSpec specOfS, int B, HeapFile* joinedFile, const BloomFilter* filter)
+{
+	typedef typename Key::Value Value;
+
+	Status status = OK;
+
+	int recLenR = specOfR.recLen;
+	int recLenS = specOfS.recLen;
+	int recLenJoined = JoinedRecLen(specOfR, specOfS);
+
+	const int recordsPerBlock = B / recLenR;
+
+	// Size the bucket array to the next power of two above the block capacity
+	int numOfBuckets = 1;
+	while (numOfBuckets < recordsPerBlock)
+	{
+		numOfBuckets <<= 1;
+	}
+	const unsigned int bucketMask = numOfBuckets - 1;
+
+	char* recBlockR = new char[B];
+	int* bucketHeads = new int[numOfBuckets];
+	int* nextInChain = new int[recordsPerBlock];
+	bool* matchedR = new bool[recordsPerBlock]; // block records that have found a match
+
+	JoinType joinType = specOfR.joinType;
+	int keyLen = specOfR.keyLen;
+
+	// The records of a page of the S partition, read in place
+	const char** recordsS = new const char*[HeapPageScan::MaxRecordsPerPage(recLenS)];
+	HeapFileAppender joinedRecords(joinedFile, recLenJoined);
+
+	RecordID ridR;
+
+	Scan* scanR = fileR->OpenScan(status);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot open scan on a partition of relation R.\n";
+		scanR = NULL;
+	}
+
+	bool lastBlock = (NULL == scanR);
+	while (!lastBlock)
+	{
+		// Fill the block and build the hash table over it
+		for (int bucket = 0; bucket < numOfBuckets; bucket++)
+		{
+			bucketHeads[bucket] = -1;
+		}
+
+		int i = 0;
+		while (i < recordsPerBlock)
+		{
+			char* currentRecordPtr = recBlockR + i*recLenR;
+			Status scanStatus = scanR->GetNext(ridR, currentRecordPtr, recLenR);
+			if (OK != scanStatus)
+			{
+				if (DONE != scanStatus)
+				{
+					cerr << "ERROR: cannot read a partition of relation R.\n";
+					status = FAIL;
+				}
+				lastBlock = true;
+				break;
+			}
+
+			Value keyR = Key::Load(currentRecordPtr + specOfR.offset, keyLen);
+			int foldedKey = Key::Fold(keyR, keyLen);
+
+			if (NULL != filter && !filter->MayContain(foldedKey))
+			{
+				if (ANTI_JOIN == joinType || LEFT_OUTER_JOIN == joinType)
+				{
+					MakeJoinedRecord(joinedRecords.NextRecord(), currentRecordPtr, NULL, specOfR, specOfS);
+				}
+				continue;
+			}
+
+			unsigned int bucket = BucketHash(foldedKey) & bucketMask;
+
+			nextInChain[i] = bucketHeads[bucket];
+			bucketHeads[bucket] = i;
+			i++;
+		}
+		int lastRecordIndex = i;
+
+		if (OK != status || 0 == lastRecordIndex)
+		{
+			break;
+		}
+
+		memset(matchedR, 0, lastRecordIndex * sizeof(bool));
+
+		// Probe the hash table with every record of the S partition
+		HeapPageScan* scanS = new HeapPageScan(fileS, status);
+		if (OK != status)
+		{
+			cerr << "ERROR: cannot open scan on a partition of relation S.\n";
+			delete scanS;
+			break;
+		}
+
+		int numOfRecordsS;
+		Status scanStatus;
+		while (OK == (scanStatus = scanS->GetNextPage(numOfRecordsS, NULL, recordsS)))
+		{
+			for (int j = 0; j < numOfRecordsS; j++)
+			{
+				const char* recS = recordsS[j];
+				Value keyS = Key::Load(&recS[specOfS.offset], keyLen);
+				unsigned int bucket = BucketHash(Key::Fold(keyS, keyLen)) & bucketMask;
+
+				for (int currentRecordIndex = bucketHeads[bucket]; currentRecordIndex != -1; currentRecordIndex = nextInChain[currentRecordIndex])
+				{
+					char* currentRecordPtr = recBlockR + (currentRecordIndex * recLenR);
+					Value keyR = Key::Load(currentRecordPtr + specOfR.offset, keyLen);
+
+					if (Key::Equal(keyR, keyS, keyLen))
+					{
+						if (INNER_JOIN == joinType || LEFT_OUTER_JOIN == joinType ||
+							(SEMI_JOIN == joinType && !matchedR[currentRecordIndex]))
+						{
+							MakeJoinedRecord(joinedRecords.NextRecord(), currentRecordPtr, recS, specOfR, specOfS);
+						}
+						matchedR[currentRecordIndex] = true;
+					}
+				}
+			}
+		}
+
+		delete scanS;
+
+		if (DONE != scanStatus)
+		{
+			cerr << "ERROR: cannot read a partition of relation S.\n";
+			status = FAIL;
+			break;
+		}
+
+		if (ANTI_JOIN == joinType || LEFT_OUTER_JOIN == joinType)
+		{
+			for (i = 0; i < lastRecordIndex; i++)
+			{
+				if (!matchedR[i])
+				{
+					MakeJoinedRecord(joinedRecords.NextRecord(), recBlockR + i*recLenR, NULL, specOfR, specOfS);
+				}
+			}
+		}
+	}
+
+	// Write out the buffered results
+	if (OK != joinedRecords.Flush())
+	{
+		cerr << "ERROR: cannot write the joined relation.\n";
+		status = FAIL;
+	}
+
+	// Release the allocated resources
+	delete scanR;
+
+	delete[] recBlockR;
+	delete[] bucketHeads;
+	delete[] nextInChain;
+	delete[] matchedR;
+	delete[] recordsS;
+
+	return status;
+}
+
+
+HeapFile* HashJoin(JoinSpec specOfR, JoinSpec specOfS)
+{
+	return HashJoin(specOfR, specOfS, (MINIBASE_BM->GetNumOfUnpinnedBuffers() - 3 * 3) * MINIBASE_PAGESIZE);
+}
+
+// The join for join keys of type Key (see joinkey.h)
+template <class Key>
+static HeapFile* HashJoin(JoinSpec specOfR, JoinSpec specOfS, int B)
+{
+	Status status = OK;
+
+	if (B < specOfR.recLen)
+	{
+		cerr << "ERROR: the buffer is too small to hold a single record of R.\n";
+		return NULL;
+	}
+
+	// Create a HeapFile for join results
+	HeapFile* joinedFile = new HeapFile(NULL, status);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot create a file for the joined relation.\n";
+		delete joinedFile;
+		return NULL;
+	}
+
+	// Choose the number of partitions so that each partition of R is
+	// expected to fit into B bytes. Every partition keeps one output
+	// page resident while partitioning, which bounds the fan-out.
+	long sizeOfR = (long)specOfR.file->GetNumOfRecords() * specOfR.recLen;
+	int numOfPartitions = (int)((sizeOfR + B - 1) / B);
+	int maxNumOfPartitions = B / MINIBASE_PAGESIZE - 1;
+
+	if (numOfPartitions > maxNumOfPartitions)
+	{
+		numOfPartitions = maxNumOfPartitions;
+	}
+
+	// Bloom filter over the join keys of S (see bloomfilter.cpp)
+	BloomFilter* filter = UseBloomFilter(specOfR) ? BuildJoinKeyFilter(specOfS) : NULL;
+
+	if (numOfPartitions <= 1)
+	{
+		// R fits into memory - build the table directly over R
+		status = JoinPartition<Key>(specOfR.file, specOfS.file, specOfR, specOfS, B, joinedFile, filter);
+		delete filter;
+		if (OK != status)
+		{
+			joinedFile->DeleteFile();
+			delete joinedFile;
+			return NULL;
+		}
+		return joinedFile;
+	}
+
+	// Partition both relations
+	HeapFile** partitionsOfR = new HeapFile*[numOfPartitions];
+	HeapFile** partitionsOfS = new HeapFile*[numOfPartitions];
+
+	// Unmatched R records are part of the result of anti and left outer
+	// joins, so those keep them in the partitions
+	bool dropUnmatchedR = (INNER_JOIN == specOfR.joinType || SEMI_JOIN == specOfR.joinType);
+
+	if (OK != PartitionFile<Key>(specOfR, partitionsOfR, numOfPartitions, dropUnmatchedR ? filter : NULL))
+	{
+		delete[] partitionsOfR;
+		delete[] partitionsOfS;
+		delete filter;
+		joinedFile->DeleteFile();
+		delete joinedFile;
+		return NULL;
+	}
+
+	if (OK != PartitionFile<Key>(specOfS, partitionsOfS, numOfPartitions, NULL))
+	{
+		DeletePartitions(partitionsOfR, numOfPartitions);
+		delete[] partitionsOfR;
+		delete[] partitionsOfS;
+		delete filter;
+		joinedFile->DeleteFile();
+		delete joinedFile;
+		return NULL;
+	}
+
+	// Build and probe each pair of partitions
+	for (int i = 0; i < numOfPartitions; i++)
+	{
+		if (OK == status)
+		{
+			status = JoinPartition<Key>(partitionsOfR[i], partitionsOfS[i], specOfR, specOfS, B, joinedFile, filter);
+		}
+
+		partitionsOfR[i]->DeleteFile();
+		partitionsOfS[i]->DeleteFile();
+		delete partitionsOfR[i];
+		delete partitionsOfS[i];
+	}
+
+	// Release the allocated resources
+	delete[] partitionsOfR;
+	delete[] partitionsOfS;
+	delete filter;
+
+	if (OK != status)
+	{
+		joinedFile->DeleteFile();
+		delete joinedFile;
+		return NULL;
+	}
+
+	return joinedFile;
+}
+
+
+HeapFile* HashJoin(JoinSpec specOfR, JoinSpec specOfS, int B)
+{
+	if (!CheckJoinKeys(specOfR, specOfS))
+	{
+		return NULL;
+	}
+
+	// Hashing only brings together equal keys
+	if (aopEQ != specOfR.joinOp)
+	{
+		return BlockNestedLoopJoin(specOfR, specOfS, B);
+	}
+
+	switch (specOfR.keyType)
+	{
+		case KEY_INT64:     return HashJoin<Int64JoinKey>(specOfR, specOfS, B);
+		case KEY_STRING:    return HashJoin<StringJoinKey>(specOfR, specOfS, B);
+		case KEY_COMPOSITE: return HashJoin<CompositeJoinKey>(specOfR, specOfS, B);
+		default:            return HashJoin<IntJoinKey>(specOfR, specOfS, B);
+	}
+}
@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/minirel.h"
+#include "../include/bufmgr.h"
+#include "../include/heapfile.h"
+#include "../include/heappage.h"
+#include "../include/dirpage.h"
+
+
+//---------------------------------------------------------------
+// Bulk appends to a HeapFile.
+//
+// InsertRecord() searches the directory for a page with enough
+// free space, pins that page and updates its directory entry for
+// every single record. AppendRecords() instead fills a page with
+// as many of the given records as fit while it stays pinned, and
+// then writes the page's directory entry once. It starts on the page
+// the previous append of the caller ended on, and takes new pages
+// from NewPage() when that is full, so that a HeapFileAppender
+// flushing many times leaves no partly filled pages behind.
+//---------------------------------------------------------------
+
+// Pages worth of records buffered by a HeapFileAppender
+#define APPENDER_PAGES 4
+
+
+//---------------------------------------------------------------
+// FillPage
+//
+// Purpose : Insert records from next on into the page of the file
+//           until it is full, and write its occupancy into its
+//           entry of the directory page dirPid.
+// Input   : newPage - TRUE if NewPage() just added the page. It is
+//                     removed from the file again if it took no
+//                     record.
+// Output  : next - the first record that is not on the page.
+// Return  : OK, DONE if the directory no longer lists the page, or
+//           FAIL if a page cannot be pinned or a record does not
+//           fit into a new page.
+//---------------------------------------------------------------
+
+static Status FillPage(PageID pid, PageID dirPid, Bool newPage, const char* recs, int recLen, int count, int& next)
+{
+	Page* pinned;
+
+	// The file may have dropped the page since an earlier append
+	// ended on it
+	if (!newPage)
+	{
+		PIN(dirPid, pinned);
+		Bool listed = (NULL != ((DirPage*)pinned)->FindPageInfo(pid)) ? TRUE : FALSE;
+		UNPIN(dirPid, CLEAN);
+
+		if (!listed)
+		{
+			return DONE;
+		}
+	}
+
+	PIN(pid, pinned);
+	HeapPage* page = (HeapPage*)pinned;
+
+	int first = next;
+	RecordID rid;
+	while (next < count && page->AvailableSpace() >= recLen)
+	{
+		if (OK != page->InsertRecord((char*)recs + next*recLen, recLen, rid))
+		{
+			break;
+		}
+		next++;
+	}
+
+	int numOfRecords = page->GetNumOfRecords();
+	int spaceAvailable = page->AvailableSpace();
+
+	UNPIN(pid, (next != first) ? DIRTY : CLEAN);
+
+	// Record the page's occupancy in its directory entry, or drop
+	// the new page again if not even one record went onto it
+	PIN(dirPid, pinned);
+	DirPage* dirPage = (DirPage*)pinned;
+
+	if (newPage && 0 == numOfRecords)
+	{
+		dirPage->DeletePage(pid);
+		UNPIN(dirPid, DIRTY);
+		FREEPAGE(pid);
+
+		cerr << "ERROR: a record of " << recLen << " bytes does not fit into a page.\n";
+		return FAIL;
+	}
+
+	PageInfo* info = dirPage->FindPageInfo(pid);
+	if (NULL != info)
+	{
+		info->numOfRecords = numOfRecords;
+		info->spaceAvailable = spaceAvailable;
+	}
+
+	UNPIN(dirPid, DIRTY);
+	return OK;
+}
+
+
+Status HeapFile::AppendRecords(const char* recs, int recLen, int count)
+{
+	PageID tailPid = INVALID_PAGE;
+	PageID tailDirPid = INVALID_PAGE;
+
+	return AppendRecords(recs, recLen, count, tailPid, tailDirPid);
+}
+
+
+//---------------------------------------------------------------
+// HeapFile::AppendRecords
+//
+// Purpose : Store count records of recLen bytes each, laid out
+//           back to back at recs, on the page the previous append
+//           ended on while it has room, then on pages newly added
+//           to the file. NewPage() registers the page in the
+//           directory and leaves it unpinned.
+// Input   : tailPid, tailDirPid - the page the previous append
+//                                 ended on and its directory page,
+//                                 or INVALID_PAGE.
+// Output  : tailPid, tailDirPid - the page this append ended on.
+// Return  : OK, or FAIL if a page cannot be allocated or a record
+//           does not fit into an empty page. A page that took no
+//           record is removed from the file again.
+//---------------------------------------------------------------
+
+Status HeapFile::AppendRecords(const char* recs, int recLen, int count, PageID& tailPid, PageID& tailDirPid)
+{
+	int next = 0;
+
+	if (INVALID_PAGE != tailPid && 0 < count)
+	{
+		Status status = FillPage(tailPid, tailDirPid, FALSE, recs, recLen, count, next);
+		if (FAIL == status)
+		{
+			return FAIL;
+		}
+		if (DONE == status)
+		{
+			tailPid = tailDirPid = INVALID_PAGE;
+		}
+	}
+
+	while (next < count)
+	{
+		PageID pid, pageDirPid;
+		if (OK != NewPage(pid, pageDirPid))
+		{
+			cerr << "ERROR: cannot allocate a new page for the heap file.\n";
+			return FAIL;
+		}
+
+		if (OK != FillPage(pid, pageDirPid, TRUE, recs, recLen, count, next))
+		{
+			return FAIL;
+		}
+
+		tailPid = pid;
+		tailDirPid = pageDirPid;
+	}
+
+	return OK;
+}
+
+
+HeapFileAppender::HeapFileAppender(HeapFile* file, int recLen) : file(file), recLen(recLen), numOfRecords(0), tailPid(INVALID_PAGE), tailDirPid(INVALID_PAGE), status(OK)
+{
+	capacity = APPENDER_PAGES * (HEAPPAGE_DATA_SIZE / (recLen + SLOT_SIZE));
+	if (capacity < 1)
+	{
+		capacity = 1;
+	}
+
+	recs = new char[capacity * recLen];
+}
+
+HeapFileAppender::~HeapFileAppender()
+{
+	// Nobody is left to check the status of records flushed only here
+	if (0 != numOfRecords && OK != Flush())
+	{
+		cerr << "ERROR: cannot write the records buffered for a heap file.\n";
+	}
+	delete[] recs;
+}
+
+char* HeapFileAppender::NextRecord()
+{
+	if (numOfRecords == capacity)
+	{
+		Flush();
+	}
+
+	return recs + (numOfRecords++ * recLen);
+}
+
+Status HeapFileAppender::Append(const char* recPtr)
+{
+	memcpy(NextRecord(), recPtr, recLen);
+	return status;
+}
+
+Status HeapFileAppender::Flush()
+{
+	if (0 != numOfRecords && OK == status)
+	{
+		status = file->AppendRecords(recs, recLen, numOfRecords, tailPid, tailDirPid);
+	}
+	numOfRecords = 0;
+
+	return status;
+}
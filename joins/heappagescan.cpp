@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/minirel.h"
+#include "../include/bufmgr.h"
+#include "../include/heapfile.h"
+#include "../include/heappage.h"
+#include "../include/dirpage.h"
+#include "../include/heappagescan.h"
+
+
+// Most data pages a directory page can list
+#define MAX_PAGES_PER_DIR_PAGE (DIR_PAGE_SIZE / sizeof(PageInfo))
+
+
+// Frames of the BufferRing of a sequential-once scan
+#define SCAN_RING_SIZE 8
+
+// Pages read ahead of the current one unless set otherwise
+#define DEFAULT_READ_AHEAD_DEPTH 4
+
+
+int HeapPageScan::readAheadDepth = DEFAULT_READ_AHEAD_DEPTH;
+
+
+HeapPageScan::HeapPageScan(HeapFile* file, Status& status, AccessHint hint)
+	: nextDirPid(file->GetFirstDirPage()), numOfPids(0), nextPid(0), ring(NULL), readAhead(NULL), nextToIssue(0), currPid(INVALID_PAGE), currPage(NULL)
+{
+	pids = new PageID[MAX_PAGES_PER_DIR_PAGE];
+	if (ACCESS_SEQUENTIAL_ONCE == hint)
+	{
+		ring = new BufferRing(SCAN_RING_SIZE);
+	}
+	status = OK;
+}
+
+HeapPageScan::~HeapPageScan()
+{
+	if (NULL != currPage)
+	{
+		MINIBASE_BM->UnpinPage(currPid, CLEAN);
+	}
+	delete readAhead;
+	delete[] pids;
+	delete ring;
+}
+
+
+//---------------------------------------------------------------
+// HeapPageScan::ReadDirPage
+//
+// Purpose : Copy the data pages listed on the next directory page
+//           into pids, so that the directory page is not kept
+//           pinned while its data pages are read.
+// Return  : OK, DONE if there are no more directory pages, or FAIL
+//           if the directory page cannot be pinned.
+//---------------------------------------------------------------
+
+Status HeapPageScan::ReadDirPage()
+{
+	if (INVALID_PAGE == nextDirPid)
+	{
+		return DONE;
+	}
+
+	Page* pinned;
+	PIN(nextDirPid, pinned);
+	DirPage* dirPage = (DirPage*)pinned;
+
+	numOfPids = 0;
+	nextPid = 0;
+	nextToIssue = 0;
+
+	PageInfoIterator entries(dirPage);
+	PageInfo* info;
+	while (NULL != (info = entries()) && numOfPids < (int)MAX_PAGES_PER_DIR_PAGE)
+	{
+		if (info->numOfRecords > 0)
+		{
+			pids[numOfPids++] = info->pid;
+		}
+	}
+
+	PageID dirPid = nextDirPid;
+	nextDirPid = dirPage->GetNextPage();
+
+	UNPIN(dirPid, CLEAN);
+
+	return OK;
+}
+
+
+Status HeapPageScan::PinNextPage(PageID& pid, HeapPage*& page)
+{
+	while (nextPid == numOfPids)
+	{
+		Status status = ReadDirPage();
+		if (OK != status)
+		{
+			return status;
+		}
+	}
+
+	pid = pids[nextPid++];
+	Page* pinned;
+	if (OK != MINIBASE_BM->PinPage(pid, pinned, FALSE, ring))
+	{
+		cerr << "Unable to pin page " << pid << endl;
+		return FAIL;
+	}
+	page = (HeapPage*)pinned;
+
+	// Read the next pages while this one is worked on
+	if (NULL != readAhead)
+	{
+		readAhead->Release(pid);
+	}
+	if (nextPid < numOfPids && readAheadDepth > 0)
+	{
+		if (NULL == readAhead)
+		{
+			readAhead = new ReadAhead(readAheadDepth, ring);
+		}
+		if (nextToIssue < nextPid)
+		{
+			nextToIssue = nextPid;
+		}
+		while (nextToIssue < numOfPids && nextToIssue < nextPid + readAheadDepth)
+		{
+			readAhead->Issue(pids[nextToIssue++]);
+		}
+	}
+
+	return OK;
+}
+
+
+Status HeapPageScan::GetNextRef(RecordID& rid, const char*& recPtr, int& recLen)
+{
+	while (true)
+	{
+		if (NULL != currPage)
+		{
+			Status status = (INVALID_SLOT == currRid.slotNo) ? currPage->FirstRecord(currRid) : currPage->NextRecord(currRid, currRid);
+			if (OK == status)
+			{
+				char* rec;
+				currPage->ReturnRecord(currRid, rec, recLen);
+
+				rid = currRid;
+				recPtr = rec;
+				return OK;
+			}
+
+			// Done with the page
+			currPage = NULL;
+			UNPIN(currPid, CLEAN);
+		}
+
+		Status status = PinNextPage(currPid, currPage);
+		if (OK != status)
+		{
+			currPage = NULL;
+			return status;
+		}
+		currRid.slotNo = INVALID_SLOT;
+	}
+}
+
+
+Status HeapPageScan::GetNextPage(int& numOfRecords, RecordID* rids, const char** recPtrs, int keyOffset, int* keys)
+{
+	if (NULL != currPage)
+	{
+		currPage = NULL;
+		UNPIN(currPid, CLEAN);
+	}
+
+	Status status = PinNextPage(currPid, currPage);
+	if (OK != status)
+	{
+		currPage = NULL;
+		return status;
+	}
+
+	numOfRecords = 0;
+
+	RecordID rid;
+	for (status = currPage->FirstRecord(rid); OK == status; status = currPage->NextRecord(rid, rid))
+	{
+		char* recPtr;
+		int recLen;
+		currPage->ReturnRecord(rid, recPtr, recLen);
+
+		if (NULL != rids)
+		{
+			rids[numOfRecords] = rid;
+		}
+		if (NULL != recPtrs)
+		{
+			recPtrs[numOfRecords] = recPtr;
+		}
+		if (NULL != keys)
+		{
+			keys[numOfRecords] = *(const int*)(recPtr + keyOffset);
+		}
+		numOfRecords++;
+	}
+
+	return OK;
+}
+
+
+int HeapPageScan::MaxRecordsPerPage(int recLen)
+{
+	// The first slot is part of the page header
+	return (HEAPPAGE_DATA_SIZE + SLOT_SIZE) / (recLen + SLOT_SIZE);
+}
+
+
+AccessHint HeapPageScan::ScanHint(HeapFile* file, int recLen)
+{
+	int numOfPages = (file->GetNumOfRecords() + MaxRecordsPerPage(recLen) - 1) / MaxRecordsPerPage(recLen);
+	return (4 * numOfPages > (int)MINIBASE_BM->GetNumOfBuffers()) ? ACCESS_SEQUENTIAL_ONCE : ACCESS_NORMAL;
+}
+
+
+void HeapPageScan::SetReadAheadDepth(int depth)
+{
+	readAheadDepth = (depth < 0) ? 0 : depth;
+}
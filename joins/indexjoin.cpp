@@ -7,10 +7,13 @@
 #include "../include/heapfile.h"
 #include "../include/scan.h"
 #include "../include/join.h"
+#include "../include/joinkey.h"
 #include "../include/btfile.h"
 #include "../include/btfilescan.h"
 #include "../include/relation.h"
 #include "../include/bufmgr.h"
+#include "../include/bloomfilter.h"
+#include "../include/heappagescan.h"
 
 
 
@@ -32,75 +35,533 @@
 //---------------------------------------------------------------
 
 
+// Close the index a join probed, destroying it if it was built
+// for the join only
+static void ReleaseJoinIndex(BTreeFile* bTree, bool temporaryIndex)
+{
+	if (temporaryIndex)
+	{
+		bTree->DestroyFile();
+	}
+	delete bTree;
+}
+
+
 HeapFile* IndexNestedLoopJoin(JoinSpec specOfR, JoinSpec specOfS)
 {
 	Status status = OK;
 
+	if (!CheckJoinKeys(specOfR, specOfS))
+	{
+		return NULL;
+	}
+
+	// The B+-tree holds int and string keys (see BuildJoinIndex); string
+	// keys are only probed for equality
+	bool stringKeys = (KEY_STRING == specOfR.keyType);
+	if (KEY_INT != specOfR.keyType && !(stringKeys && aopEQ == specOfR.joinOp))
+	{
+		return BlockNestedLoopJoin(specOfR, specOfS);
+	}
+
+	// Open the persisted index on the inner relation (S), or build a
+	// temporary one if the specification does not name an index
+	bool temporaryIndex = ('\0' == specOfS.indexName[0]);
+
+	BTreeFile* bTree = temporaryIndex ? BuildJoinIndex(specOfS, "IJBT") : OpenJoinIndex(specOfS);
+	if (NULL == bTree)
+	{
+		cerr << "ERROR: cannot open the B+-tree index on the relation S.\n";
+		return NULL;
+	}
+
 	// Create a HeapFile for join results
 	HeapFile* joinedFile = new HeapFile(NULL, status);
 	if (OK != status)
 	{
 		cerr << "ERROR: cannot create a file for the joined relation.\n";
+		delete joinedFile;
+		ReleaseJoinIndex(bTree, temporaryIndex);
 		return NULL;
 	}
 
-	int recLenR = specOfR.recLen;
+	// Iterate through the outer relation (R) and join
+	HeapPageScan* scanR = new HeapPageScan(specOfR.file, status);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot open scan on the relation R heap file.\n";
+		delete scanR;
+		joinedFile->DeleteFile();
+		delete joinedFile;
+		ReleaseJoinIndex(bTree, temporaryIndex);
+		return NULL;
+	}
+
+	int recLenR;
 	int recLenS = specOfS.recLen;
-	int recLenJoined = recLenR + recLenS;
+	int recLenJoined = JoinedRecLen(specOfR, specOfS);
 
-	char* recR = new char[recLenR];
+	const char* recR; // read in place on the pages of R
 	char* recS = new char[recLenS];
-	char* recJoined = new char[recLenJoined];
+	HeapFileAppender joinedRecords(joinedFile, recLenJoined);
+
+	RecordID ridR, ridS;
+
+	JoinType joinType = specOfR.joinType;
+
+	// Bloom filter over the join keys of S (see bloomfilter.cpp)
+	BloomFilter* filter = UseBloomFilter(specOfR) ? BuildJoinKeyFilter(specOfS) : NULL;
+
+	char keyR[MAX_STRING_KEY_LEN+1];
+	char keyS[MAX_STRING_KEY_LEN+1];
+
+	Status scanStatus;
+	while (OK == (scanStatus = scanR->GetNextRef(ridR, recR, recLenR)))
+	{
+		const int* joinArgR = (const int*)&recR[specOfR.offset];
+
+		// Probe the range of S keys that can satisfy the join predicate
+		bool matched = false;
+		BTreeFileScan* bTreeScan = NULL;
+
+		// Keys the filter rejects have no partner in S and are not probed
+		bool probe = (NULL == filter || filter->MayContain(FoldJoinKey(recR, specOfR)));
+
+		if (probe && stringKeys)
+		{
+			MakeIndexKey(keyR, recR, specOfR);
+			bTreeScan = (BTreeFileScan*)bTree->OpenSearchScan(keyR, keyR);
+		}
+		else if (probe)
+		{
+			int lowKey, highKey;
+			if (MatchingKeysOfS(*joinArgR, specOfR, lowKey, highKey))
+			{
+				bTreeScan = (BTreeFileScan*)bTree->OpenSearchScan(&lowKey, &highKey);
+			}
+		}
+
+		if (NULL != bTreeScan)
+		{
+			Status probeStatus;
+			while (OK == (probeStatus = bTreeScan->GetNext(ridS, keyS)))
+			{
+				// String probes only return equal keys
+				if (!stringKeys && !JoinKeysMatch(*joinArgR, *(int*)keyS, specOfR))
+				{
+					continue;
+				}
+				matched = true;
+
+				// The index entry alone decides a semi or anti join; S records are not fetched
+				if (SEMI_JOIN == joinType || ANTI_JOIN == joinType)
+				{
+					probeStatus = DONE;
+					break;
+				}
+
+				if (OK != specOfS.file->GetRecord(ridS, recS, recLenS))
+				{
+					cerr << "ERROR: cannot read a record of the relation S.\n";
+					status = FAIL;
+					probeStatus = DONE;
+					break;
+				}
+
+				MakeJoinedRecord(joinedRecords.NextRecord(), recR, recS, specOfR, specOfS);
+			}
+			delete bTreeScan;
 
-	RecordID ridR, ridS, ridJoined;
+			if (DONE != probeStatus)
+			{
+				cerr << "ERROR: cannot probe the B+-tree index on the relation S.\n";
+				status = FAIL;
+			}
+			if (OK != status)
+			{
+				break;
+			}
+		}
+
+		// R records that are returned without an S record
+		if (matched ? (SEMI_JOIN == joinType) : (ANTI_JOIN == joinType || LEFT_OUTER_JOIN == joinType))
+		{
+			MakeJoinedRecord(joinedRecords.NextRecord(), recR, NULL, specOfR, specOfS);
+		}
+	}
+
+	if (OK == status && DONE != scanStatus)
+	{
+		cerr << "ERROR: cannot read the relation R.\n";
+		status = FAIL;
+	}
+
+	// Write out the buffered results
+	if (OK != joinedRecords.Flush() && OK == status)
+	{
+		cerr << "ERROR: cannot write the joined relation.\n";
+		status = FAIL;
+	}
+
+	// Release the allocated resources
+	delete scanR;
+
+	delete[] recS;
+	delete filter;
+
+	ReleaseJoinIndex(bTree, temporaryIndex);
 
-	// Build the B+-tree index on the inner relation (S)
-	Scan* scanS = specOfS.file->OpenScan(status);
 	if (OK != status)
 	{
-		cerr << "ERROR: cannot open scan on the relation S heap file.\n";
+		joinedFile->DeleteFile();
+		delete joinedFile;
 		return NULL;
 	}
 
-	BTreeFile* bTree = new BTreeFile(status, "IJBT", ATTR_INT, sizeof(int));
-	while (OK == scanS->GetNext(ridS, recS, recLenS))
+	return joinedFile;
+}
+
+
+//---------------------------------------------------------------
+// Batched index nested loop join.
+//
+// R is read in batches of at most B bytes. The batch is sorted on
+// the join key and the index is probed with a single range scan
+// from the smallest to the largest key of the batch, which walks
+// the leaf chain forwards once instead of descending from the root
+// for every R tuple. The matching S record ids are then sorted by
+// page number, so each page of S is fetched in order and at most
+// once per batch. At most B bytes of matches are kept; a wide
+// predicate that finds more emits them a chunk at a time.
+//---------------------------------------------------------------
+
+struct BatchEntry
+{
+	int key;   // join key of the R record
+	int index; // position of the R record in the batch
+};
+
+struct BatchMatch
+{
+	int      index; // position of the R record in the batch
+	RecordID ridS;  // matching S record
+};
+
+static int CompareBatchEntries(const void* a, const void* b)
+{
+	const BatchEntry* entryA = (const BatchEntry*)a;
+	const BatchEntry* entryB = (const BatchEntry*)b;
+
+	if (entryA->key != entryB->key)
 	{
-		bTree->Insert(recS + specOfS.offset, ridS);
+		return (entryA->key < entryB->key) ? -1 : 1;
+	}
+	return entryA->index - entryB->index;
+}
+
+static int CompareBatchMatches(const void* a, const void* b)
+{
+	const BatchMatch* matchA = (const BatchMatch*)a;
+	const BatchMatch* matchB = (const BatchMatch*)b;
+
+	if (matchA->ridS.pageNo != matchB->ridS.pageNo)
+	{
+		return (matchA->ridS.pageNo < matchB->ridS.pageNo) ? -1 : 1;
+	}
+	if (matchA->ridS.slotNo != matchB->ridS.slotNo)
+	{
+		return matchA->ridS.slotNo - matchB->ridS.slotNo;
+	}
+	return matchA->index - matchB->index;
+}
+
+
+// Fetch the S records of the matches in page order and join them
+// with their batch records. FAIL if an S record cannot be read.
+static Status EmitMatches(BatchMatch* matches, int numOfMatches, const char* recBatchR, char* recS,
+						  const JoinSpec& specOfR, const JoinSpec& specOfS, HeapFileAppender& joinedRecords)
+{
+	qsort(matches, numOfMatches, sizeof(BatchMatch), CompareBatchMatches);
+
+	for (int i = 0; i < numOfMatches; i++)
+	{
+		if (0 == i || matches[i].ridS != matches[i - 1].ridS)
+		{
+			int recLenS = specOfS.recLen;
+			if (OK != specOfS.file->GetRecord(matches[i].ridS, recS, recLenS))
+			{
+				cerr << "ERROR: cannot read a record of the relation S.\n";
+				return FAIL;
+			}
+		}
+
+		MakeJoinedRecord(joinedRecords.NextRecord(), recBatchR + matches[i].index * specOfR.recLen, recS, specOfR, specOfS);
+	}
+
+	return OK;
+}
+
+
+HeapFile* IndexNestedLoopJoin(JoinSpec specOfR, JoinSpec specOfS, int B)
+{
+	Status status = OK;
+
+	if (!CheckJoinKeys(specOfR, specOfS))
+	{
+		return NULL;
+	}
+
+	// The R records matching an S key form an interval of the sorted
+	// batch for every predicate but aopNE, which is probed per record,
+	// as are keys other than ints
+	if (aopNE == specOfR.joinOp || KEY_INT != specOfR.keyType)
+	{
+		return IndexNestedLoopJoin(specOfR, specOfS);
+	}
+
+	int recLenR = specOfR.recLen;
+	int recLenS = specOfS.recLen;
+	int recLenJoined = JoinedRecLen(specOfR, specOfS);
+
+	const int recordsPerBatch = B / recLenR;
+	if (recordsPerBatch < 1)
+	{
+		cerr << "ERROR: the buffer is too small to hold a single record of R.\n";
+		return NULL;
+	}
+
+	// Open the persisted index on the inner relation (S), or build a
+	// temporary one if the specification does not name an index
+	bool temporaryIndex = ('\0' == specOfS.indexName[0]);
+
+	BTreeFile* bTree = temporaryIndex ? BuildJoinIndex(specOfS, "IJBT") : OpenJoinIndex(specOfS);
+	if (NULL == bTree)
+	{
+		cerr << "ERROR: cannot open the B+-tree index on the relation S.\n";
+		return NULL;
+	}
+
+	// Create a HeapFile for join results
+	HeapFile* joinedFile = new HeapFile(NULL, status);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot create a file for the joined relation.\n";
+		delete joinedFile;
+		ReleaseJoinIndex(bTree, temporaryIndex);
+		return NULL;
 	}
-	delete scanS;
 
-	// Iterate through the outer relation (R) and join
 	Scan* scanR = specOfR.file->OpenScan(status);
 	if (OK != status)
 	{
 		cerr << "ERROR: cannot open scan on the relation R heap file.\n";
+		delete scanR;
+		joinedFile->DeleteFile();
+		delete joinedFile;
+		ReleaseJoinIndex(bTree, temporaryIndex);
 		return NULL;
 	}
 
-	while (OK == scanR->GetNext(ridR, recR, recLenR))
+	char* recBatchR = new char[recordsPerBatch * recLenR];
+	BatchEntry* entries = new BatchEntry[recordsPerBatch];
+
+	// Matches waiting for their S records, B bytes' worth
+	int matchCapacity = B / (int)sizeof(BatchMatch);
+	if (matchCapacity < 1)
+	{
+		matchCapacity = 1;
+	}
+	BatchMatch* matches = new BatchMatch[matchCapacity];
+
+	// Batch records that have found a match
+	bool* matchedR = new bool[recordsPerBatch];
+
+	char* recS = new char[recLenS];
+	HeapFileAppender joinedRecords(joinedFile, recLenJoined);
+
+	RecordID ridR, ridS;
+
+	JoinType joinType = specOfR.joinType;
+	bool keepPairs = (INNER_JOIN == joinType || LEFT_OUTER_JOIN == joinType);
+
+	// Bloom filter over the join keys of S (see bloomfilter.cpp)
+	BloomFilter* filter = UseBloomFilter(specOfR) ? BuildJoinKeyFilter(specOfS) : NULL;
+
+	bool lastBatch = false;
+	while (!lastBatch && OK == status)
 	{
-		int* joinArgR = (int*)&recR[specOfR.offset];
+		// Fill the batch
+		int numOfEntries = 0;
+		while (numOfEntries < recordsPerBatch)
+		{
+			char* currentRecordPtr = recBatchR + numOfEntries*recLenR;
+			Status scanStatus = scanR->GetNext(ridR, currentRecordPtr, recLenR);
+			if (OK != scanStatus)
+			{
+				if (DONE != scanStatus)
+				{
+					cerr << "ERROR: cannot read the relation R.\n";
+					status = FAIL;
+				}
+				lastBatch = true;
+				break;
+			}
+
+			int keyR = *(int*)(currentRecordPtr + specOfR.offset);
+
+			// Records without a partner in S stay out of the batch
+			if (NULL != filter && !filter->MayContain(keyR))
+			{
+				if (ANTI_JOIN == joinType || LEFT_OUTER_JOIN == joinType)
+				{
+					MakeJoinedRecord(joinedRecords.NextRecord(), currentRecordPtr, NULL, specOfR, specOfS);
+				}
+				continue;
+			}
+
+			entries[numOfEntries].key = keyR;
+			entries[numOfEntries].index = numOfEntries;
+			numOfEntries++;
+		}
+
+		if (OK != status || 0 == numOfEntries)
+		{
+			break;
+		}
+
+		qsort(entries, numOfEntries, sizeof(BatchEntry), CompareBatchEntries);
 
-		BTreeFileScan* bTreeScan = (BTreeFileScan*)bTree->OpenSearchScan(joinArgR, joinArgR);
+		memset(matchedR, 0, numOfEntries * sizeof(bool));
+
+		// Sweep the leaves between the smallest S key matching the smallest
+		// R key and the largest S key matching the largest R key once. As
+		// the S keys grow, the interval [first, last) of batch entries they
+		// match slides forwards.
+		int numOfMatches = 0;
+		int first = 0, last = 0;
+
+		int lowKey, highKey, unusedKey;
+		bool matchesSmallest = MatchingKeysOfS(entries[0].key, specOfR, lowKey, unusedKey);
+		bool matchesLargest = MatchingKeysOfS(entries[numOfEntries - 1].key, specOfR, unusedKey, highKey);
+		if (!matchesSmallest && !matchesLargest)
+		{
+			first = numOfEntries; // nothing in the batch can match
+		}
+		else if (!matchesSmallest)
+		{
+			MatchingKeysOfS(entries[numOfEntries - 1].key, specOfR, lowKey, highKey);
+		}
+		else if (!matchesLargest)
+		{
+			MatchingKeysOfS(entries[0].key, specOfR, lowKey, highKey);
+		}
+
+		BTreeFileScan* bTreeScan = (first < numOfEntries) ? (BTreeFileScan*)bTree->OpenSearchScan(&lowKey, &highKey) : NULL;
+		Status probeStatus = DONE;
 		int key;
-		while (OK == bTreeScan->GetNext(ridS, &key))
+		while (first < numOfEntries && OK == status && OK == (probeStatus = bTreeScan->GetNext(ridS, &key)))
 		{
-		    specOfS.file->GetRecord(ridS, recS, recLenS);
+			int lowR, highR;
+			if (!MatchingKeysOfR(key, specOfR, lowR, highR))
+			{
+				continue;
+			}
+
+			while (first < numOfEntries && entries[first].key < lowR)
+			{
+				first++;
+			}
+			if (last < first)
+			{
+				last = first;
+			}
+			while (last < numOfEntries && entries[last].key <= highR)
+			{
+				last++;
+			}
+
+			for (int i = first; i < last; i++)
+			{
+				matchedR[entries[i].index] = true;
 
-			MakeNewRecord(recJoined, recR, recS, recLenR, recLenS);
-			joinedFile->InsertRecord(recJoined, recLenJoined, ridJoined);
+				// Semi and anti joins only need to know that there is a match
+				if (!keepPairs)
+				{
+					continue;
+				}
+
+				if (numOfMatches == matchCapacity)
+				{
+					status = EmitMatches(matches, numOfMatches, recBatchR, recS, specOfR, specOfS, joinedRecords);
+					numOfMatches = 0;
+					if (OK != status)
+					{
+						break;
+					}
+				}
+
+				matches[numOfMatches].index = entries[i].index;
+				matches[numOfMatches].ridS = ridS;
+				numOfMatches++;
+			}
 		}
 		delete bTreeScan;
+
+		if (OK == status && DONE != probeStatus && first < numOfEntries)
+		{
+			cerr << "ERROR: cannot probe the B+-tree index on the relation S.\n";
+			status = FAIL;
+		}
+		if (OK != status)
+		{
+			break;
+		}
+
+		// Fetch the matching S records in page order
+		status = EmitMatches(matches, numOfMatches, recBatchR, recS, specOfR, specOfS, joinedRecords);
+		if (OK != status)
+		{
+			break;
+		}
+
+		// R records that are returned without an S record
+		if (INNER_JOIN != joinType)
+		{
+			for (int i = 0; i < numOfEntries; i++)
+			{
+				if (matchedR[i] == (SEMI_JOIN == joinType))
+				{
+					MakeJoinedRecord(joinedRecords.NextRecord(), recBatchR + i * recLenR, NULL, specOfR, specOfS);
+				}
+			}
+		}
+	}
+
+	// Write out the buffered results
+	if (OK != joinedRecords.Flush() && OK == status)
+	{
+		cerr << "ERROR: cannot write the joined relation.\n";
+		status = FAIL;
 	}
 
 	// Release the allocated resources
 	delete scanR;
 
-	delete[] recR;
+	delete[] recBatchR;
+	delete[] entries;
+	delete[] matches;
+	delete[] matchedR;
 	delete[] recS;
-	delete[] recJoined;
+	delete filter;
 
-	delete bTree;
+	ReleaseJoinIndex(bTree, temporaryIndex);
+
+	if (OK != status)
+	{
+		joinedFile->DeleteFile();
+		delete joinedFile;
+		return NULL;
+	}
 
 	return joinedFile;
 }
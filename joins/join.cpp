@@ -5,9 +5,8 @@
 #include "../include/minirel.h"
 #include "../include/heapfile.h"
 #include "../include/scan.h"
-#include "../include/btfile.h"
-#include "../include/btfilescan.h"
 #include "../include/join.h"
+#include "../include/operator.h"
 
 //-----------------------------------------------------------------
 // MakeNewRecord
@@ -29,9 +28,168 @@ void MakeNewRecord (char *newRecord, char *r, char *s, int recLenR, int recLenS)
 }
 
 
-//--------------------------------------------------------------------
-// This is a USEFUL function to sort a file.    It is also very useful
-// to understand how to use HeapFile, Scan, BTreeFile, BTreeFileScan.
+//-----------------------------------------------------------------
+// ProjectRecord
+//
+// Purpose : Copy the output attributes of a record to dest, or
+//           NULL_ATTR for each of them if rec is NULL. The bytes of
+//           a whole record that do not make up an int are zeroed.
+// Return  : The position in dest following the copied attributes.
+//-----------------------------------------------------------------
+
+static char* ProjectRecord(char *dest, const char *rec, const JoinSpec &spec)
+{
+	if (NULL == rec)
+	{
+		int numOfAttr = (ALL_ATTR == spec.numOfOutAttr) ? spec.recLen / sizeof(int) : spec.numOfOutAttr;
+		for (int i = 0; i < numOfAttr; i++)
+		{
+			*(int*)dest = NULL_ATTR;
+			dest += sizeof(int);
+		}
+
+		if (ALL_ATTR == spec.numOfOutAttr)
+		{
+			int tailLen = spec.recLen % sizeof(int);
+			memset(dest, 0, tailLen);
+			dest += tailLen;
+		}
+		return dest;
+	}
+
+	if (ALL_ATTR == spec.numOfOutAttr)
+	{
+		memcpy(dest, rec, spec.recLen);
+		return dest + spec.recLen;
+	}
+
+	for (int i = 0; i < spec.numOfOutAttr; i++)
+	{
+		memcpy(dest, rec + spec.outAttr[i]*sizeof(int), sizeof(int));
+		dest += sizeof(int);
+	}
+	return dest;
+}
+
+
+//-----------------------------------------------------------------
+// MakeJoinedRecord
+//
+// Purpose : Create a join result record from two matching records,
+//           keeping only the output attributes of each relation,
+//           those of r first. Semi and anti joins (specOfR.joinType)
+//           keep r only; a NULL s is padded with NULL_ATTR.
+// Precond : newRecord has at least JoinedRecLen(specOfR, specOfS)
+//           bytes
+//-----------------------------------------------------------------
+
+void MakeJoinedRecord(char *newRecord, const char *r, const char *s, const JoinSpec &specOfR, const JoinSpec &specOfS)
+{
+	char *sPart = ProjectRecord(newRecord, r, specOfR);
+
+	if (SEMI_JOIN != specOfR.joinType && ANTI_JOIN != specOfR.joinType)
+	{
+		ProjectRecord(sPart, s, specOfS);
+	}
+}
+
+int JoinedRecLen(const JoinSpec &specOfR, const JoinSpec &specOfS)
+{
+	int recLenR = (ALL_ATTR == specOfR.numOfOutAttr) ? specOfR.recLen : specOfR.numOfOutAttr * sizeof(int);
+	int recLenS = (ALL_ATTR == specOfS.numOfOutAttr) ? specOfS.recLen : specOfS.numOfOutAttr * sizeof(int);
+
+	if (SEMI_JOIN == specOfR.joinType || ANTI_JOIN == specOfR.joinType)
+	{
+		return recLenR;
+	}
+	return recLenR + recLenS;
+}
+
+
+//-----------------------------------------------------------------
+// CheckOutAttr
+//
+// Purpose : Check that the output attributes of a relation are at
+//           most MAX_ATTR ints of its records.
+//-----------------------------------------------------------------
+
+static bool CheckOutAttr(const JoinSpec &spec)
+{
+	if (ALL_ATTR == spec.numOfOutAttr)
+	{
+		return true;
+	}
+
+	if (spec.numOfOutAttr < 0 || spec.numOfOutAttr > MAX_ATTR)
+	{
+		cerr << "ERROR: " << spec.numOfOutAttr << " output attributes of " << spec.relName << " requested, at most " << MAX_ATTR << " allowed.\n";
+		return false;
+	}
+
+	for (int i = 0; i < spec.numOfOutAttr; i++)
+	{
+		if (spec.outAttr[i] < 0 || (spec.outAttr[i] + 1) * (int)sizeof(int) > spec.recLen)
+		{
+			cerr << "ERROR: output attribute " << spec.outAttr[i] << " lies outside the records of " << spec.relName << ".\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+//-----------------------------------------------------------------
+// CheckJoinKeys
+//
+// Purpose : Check that the join attributes of R and S have the same
+//           type, that their length suits the type and that the
+//           join predicate applies to it, and that the output
+//           attributes lie within the records.
+// Return  : true if the relations can be joined, false otherwise.
+//-----------------------------------------------------------------
+
+bool CheckJoinKeys(const JoinSpec &specOfR, const JoinSpec &specOfS)
+{
+	if (!CheckOutAttr(specOfR) || !CheckOutAttr(specOfS))
+	{
+		return false;
+	}
+
+	if (specOfR.keyType != specOfS.keyType || specOfR.keyLen != specOfS.keyLen)
+	{
+		cerr << "ERROR: the join attributes of " << specOfR.relName << " and " << specOfS.relName << " have different types.\n";
+		return false;
+	}
+
+	int keyLen = specOfR.keyLen;
+	bool validKeyLen;
+
+	switch (specOfR.keyType)
+	{
+		case KEY_INT:       validKeyLen = ((int)sizeof(int) == keyLen); break;
+		case KEY_INT64:     validKeyLen = ((int)sizeof(long long) == keyLen); break;
+		case KEY_STRING:    validKeyLen = (keyLen > 0 && keyLen <= MAX_STRING_KEY_LEN); break;
+		case KEY_COMPOSITE: validKeyLen = (keyLen > 0 && 0 == keyLen % (int)sizeof(int)); break;
+		default:            validKeyLen = false; break;
+	}
+
+	if (!validKeyLen || specOfR.offset + keyLen > specOfR.recLen || specOfS.offset + keyLen > specOfS.recLen)
+	{
+		cerr << "ERROR: join attributes of " << keyLen << " bytes do not suit their type.\n";
+		return false;
+	}
+
+	if (opRANGE == specOfR.joinOp && KEY_INT != specOfR.keyType && KEY_INT64 != specOfR.keyType)
+	{
+		cerr << "ERROR: band joins need integer join attributes.\n";
+		return false;
+	}
+
+	return true;
+}
+
+
 //--------------------------------------------------------------------
 // SortFile
 // 
@@ -40,67 +198,81 @@ void MakeNewRecord (char *newRecord, char *r, char *s, int recLenR, int recLenS)
 //            len - length of the record in the file S. (assume fixed
 //				    size.
 //            offset - offset of the attribute from the beginning of the record.
-// Cheat    : We create a B+-Tree using that attribute as the key. Then
-//            we scan the B+-Tree and insert the records into a new
-//            HeapFile.   The HeapFile guarantees that the order of 
-//            insertion will be the same as the order of scan later.
+// Method   : External merge sort (see SortOperator). Runs are sized
+//            to the unpinned buffer frames and merged with a fan-in
+//            derived from the same number of frames; the final merge
+//            is written straight into the result.
 // Return   : The new sorted relation/HeapFile.
 //-------------------------------------------------------------------- 
 
 HeapFile *SortFile(HeapFile *S, int len, int offset)
 {
-	Status s;
+	HeapScanOperator scan(S, len);
+	SortOperator sort(&scan, offset);
 
-	Scan *scan;
-	scan = S->OpenScan(s);
-	if (s != OK)
-	{
-		cerr << "ERROR : cannot open scan on the heapfile to sort.\n";
-	}
+	return Materialize(&sort);
+}
 
-	//
-	// Scan the HeapFile S, new a B+Tree and insert the records into B+Tree.
-	// 
 
-	BTreeFile *btree;
-	btree = new BTreeFile (s, "BTree", ATTR_INT, sizeof(int));
+//-----------------------------------------------------------------
+// MatchingKeysOfS / MatchingKeysOfR
+//
+// Purpose : Translate the join predicate into an inclusive interval
+//           of the other relation's keys, for range probes of an
+//           index or a sorted run. Unbounded ends are INT_MIN and
+//           INT_MAX.
+//-----------------------------------------------------------------
 
-	char *recPtr = new char[len];
-	int recLen = len;
-	RecordID rid;
-	while (scan->GetNext(rid, recPtr, recLen) == OK)
+static bool ClampKeyRange(long long low, long long high, int &lowKey, int &highKey)
+{
+	if (low < INT_MIN)
 	{
-		btree->Insert(recPtr + offset, rid);
+		low = INT_MIN;
 	}
-	delete scan;
-
-	HeapFile *sorted;
-	sorted = new HeapFile(NULL, s); // create a temp HeapFile
-	if (s != OK)
+	if (high > INT_MAX)
 	{
-	    	cerr << "Cannot create new file for sortedS\n";
+		high = INT_MAX;
+	}
+	if (low > high)
+	{
+		return false;
 	}
 
-	//
-	// Now scan the B+-Tree and insert the records into a 
-	// new (sorted) HeapFile.
-	//
-
-	BTreeFileScan  *btreeScan;
-	btreeScan = (BTreeFileScan *)btree->OpenScan(NULL, NULL);
+	lowKey = (int)low;
+	highKey = (int)high;
+	return true;
+}
 
-	int key;
+bool MatchingKeysOfS(int keyR, const JoinSpec &specOfR, int &lowS, int &highS)
+{
+	long long key = keyR;
 
-	while (btreeScan->GetNext(rid, &key) == OK)
+	switch (specOfR.joinOp)
 	{
-	    S->GetRecord (rid, recPtr, recLen);
-	    sorted->InsertRecord (recPtr, recLen, rid);
+		case aopEQ:   return ClampKeyRange(key, key, lowS, highS);
+		case aopNE:   return ClampKeyRange(INT_MIN, INT_MAX, lowS, highS);
+		case aopLT:   return ClampKeyRange(key + 1, INT_MAX, lowS, highS); // R < S
+		case aopLE:   return ClampKeyRange(key, INT_MAX, lowS, highS);
+		case aopGT:   return ClampKeyRange(INT_MIN, key - 1, lowS, highS); // R > S
+		case aopGE:   return ClampKeyRange(INT_MIN, key, lowS, highS);
+		case opRANGE: return ClampKeyRange(key - specOfR.bandWidth, key + specOfR.bandWidth, lowS, highS);
+		default:      return false;
 	}
-	btree->DestroyFile();
+}
 
-	delete btree;
-	delete btreeScan;
-	delete [] recPtr;
+bool MatchingKeysOfR(int keyS, const JoinSpec &specOfR, int &lowR, int &highR)
+{
+	long long key = keyS;
 
-	return sorted;
+	switch (specOfR.joinOp)
+	{
+		case aopEQ:   return ClampKeyRange(key, key, lowR, highR);
+		case aopNE:   return ClampKeyRange(INT_MIN, INT_MAX, lowR, highR);
+		case aopLT:   return ClampKeyRange(INT_MIN, key - 1, lowR, highR); // R < S
+		case aopLE:   return ClampKeyRange(INT_MIN, key, lowR, highR);
+		case aopGT:   return ClampKeyRange(key + 1, INT_MAX, lowR, highR); // R > S
+		case aopGE:   return ClampKeyRange(key, INT_MAX, lowR, highR);
+		case opRANGE: return ClampKeyRange(key - specOfR.bandWidth, key + specOfR.bandWidth, lowR, highR);
+		default:      return false;
+	}
 }
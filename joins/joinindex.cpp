@@ -0,0 +1,574 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/minirel.h"
+#include "../include/db.h"
+#include "../include/heapfile.h"
+#include "../include/scan.h"
+#include "../include/join.h"
+#include "../include/btfile.h"
+#include "../include/heappagescan.h"
+#include "../include/operator.h"
+
+
+//---------------------------------------------------------------
+// Join indexes.
+//
+// A JoinSpec may name a B+-tree index on the join attribute of its
+// relation (JoinSpec::indexName). Such an index is built the first
+// time a join asks for it, is registered in the DB file directory
+// under that name by BTreeFile, and is reopened by later joins.
+// Records inserted or deleted through InsertIntoRelation() and
+// DeleteFromRelation() are reflected in the index.
+//
+// HeapFile knows nothing of the index, so records inserted or
+// deleted on the heap file directly are not. The number of records
+// the index holds is therefore kept with it (see the index stamp
+// below), and an index whose count differs from the relation's is
+// rebuilt when it is opened.
+//
+// KEY_INT join attributes are indexed as ATTR_INT keys and
+// KEY_STRING ones as NUL terminated ATTR_STRING keys; the B+-tree
+// has no key type for the other join key types.
+//---------------------------------------------------------------
+
+
+//---------------------------------------------------------------
+// IndexKeyLen / MakeIndexKey
+//
+// Purpose : The length of the index keys on the join attribute,
+//           and the index key of a record. A string key is padded
+//           with NULs up to its length and NUL terminated.
+//---------------------------------------------------------------
+
+int IndexKeyLen(const JoinSpec &spec)
+{
+	return (KEY_STRING == spec.keyType) ? spec.keyLen + 1 : (int)sizeof(int);
+}
+
+void MakeIndexKey(char* key, const char* rec, const JoinSpec &spec)
+{
+	if (KEY_STRING == spec.keyType)
+	{
+		strncpy(key, rec + spec.offset, spec.keyLen);
+		key[spec.keyLen] = '\0';
+	}
+	else
+	{
+		memcpy(key, rec + spec.offset, sizeof(int));
+	}
+}
+
+
+// The <key, rid> pairs of a relation as records: the index key of a
+// record, padded to a multiple of sizeof(int), followed by its RID
+class IndexEntryOperator : public Operator
+{
+	public:
+
+		IndexEntryOperator(JoinSpec spec) : spec(spec), scan(NULL)
+		{
+			ridOffset = (IndexKeyLen(spec) + sizeof(int) - 1) / sizeof(int) * sizeof(int);
+			recLen = ridOffset + sizeof(RecordID);
+		}
+
+		~IndexEntryOperator()
+		{
+			Close();
+		}
+
+		Status Open()
+		{
+			Status status = OK;
+
+			Close();
+
+			scan = new HeapPageScan(spec.file, status);
+			if (OK != status)
+			{
+				cerr << "ERROR: cannot open scan on the relation " << spec.relName << " heap file.\n";
+				delete scan;
+				scan = NULL;
+				return FAIL;
+			}
+
+			return OK;
+		}
+
+		Status GetNext(char* recPtr)
+		{
+			const char* rec;
+			int len;
+			RecordID rid;
+
+			if (NULL == scan)
+			{
+				return FAIL;
+			}
+
+			Status status = scan->GetNextRef(rid, rec, len);
+			if (OK != status)
+			{
+				return status;
+			}
+
+			memset(recPtr, 0, ridOffset);
+			MakeIndexKey(recPtr, rec, spec);
+			memcpy(recPtr + ridOffset, &rid, sizeof(RecordID));
+
+			return OK;
+		}
+
+		void Close()
+		{
+			delete scan;
+			scan = NULL;
+		}
+
+		int RidOffset() { return ridOffset; }
+
+	private:
+
+		JoinSpec spec;
+		HeapPageScan* scan;
+		int ridOffset;
+};
+
+// Feeds the records of an open IndexEntryOperator, or of an operator
+// sorting them, to BTreeFile::BulkLoad
+class IndexEntrySource : public BulkLoadSource
+{
+	public:
+
+		IndexEntrySource(Operator* entries, int keyLen, int ridOffset) : entries(entries), keyLen(keyLen), ridOffset(ridOffset)
+		{
+			entry = new char[entries->RecLen()];
+		}
+
+		~IndexEntrySource()
+		{
+			delete[] entry;
+		}
+
+		Status GetNext(RecordID& rid, void* keyptr)
+		{
+			Status status = entries->GetNext(entry);
+			if (OK != status)
+			{
+				return status;
+			}
+
+			memcpy(&rid, entry + ridOffset, sizeof(RecordID));
+			memcpy(keyptr, entry, keyLen);
+
+			return OK;
+		}
+
+	private:
+
+		Operator* entries;
+		int keyLen;
+		int ridOffset;
+		char* entry;
+};
+
+
+//---------------------------------------------------------------
+// BulkLoadRelation
+//
+// Purpose : Sort the <key, rid> pairs of the relation with an
+//           external merge sort (see SortOperator) and bulk load
+//           them into an empty B+-tree as they come out of the
+//           sort, so that no more of the relation than the free
+//           buffer frames hold is kept in memory.
+//---------------------------------------------------------------
+
+static Status BulkLoadRelation(BTreeFile* bTree, JoinSpec spec)
+{
+	IndexEntryOperator entries(spec);
+	SortOperator sort(&entries, 0, (KEY_STRING == spec.keyType) ? ATTR_STRING : ATTR_INT, IndexKeyLen(spec));
+
+	if (OK != sort.Open())
+	{
+		cerr << "ERROR: cannot sort the index entries of relation " << spec.relName << ".\n";
+		return FAIL;
+	}
+
+	IndexEntrySource source(&sort, IndexKeyLen(spec), entries.RidOffset());
+	Status status = bTree->BulkLoad(&source);
+
+	sort.Close();
+
+	return status;
+}
+
+
+//---------------------------------------------------------------
+// BuildJoinIndex
+//
+// Purpose : Create a B+-tree called indexName over the join
+//           attribute of the relation, by sorting its <key, rid>
+//           pairs and bulk loading them.
+// Return  : The open index, or NULL on failure.
+//---------------------------------------------------------------
+
+BTreeFile* BuildJoinIndex(JoinSpec spec, const char* indexName)
+{
+	Status status = OK;
+
+	if (KEY_INT != spec.keyType && KEY_STRING != spec.keyType)
+	{
+		cerr << "ERROR: the join attribute of relation " << spec.relName << " cannot be indexed.\n";
+		return NULL;
+	}
+
+	bool stringKeys = (KEY_STRING == spec.keyType);
+
+	BTreeFile* bTree = new BTreeFile(status, indexName, stringKeys ? ATTR_STRING : ATTR_INT, IndexKeyLen(spec));
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot create the B+-tree " << indexName << ".\n";
+		delete bTree;
+		return NULL;
+	}
+
+	status = BulkLoadRelation(bTree, spec);
+
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot bulk load the B+-tree " << indexName << ".\n";
+		bTree->DestroyFile();
+		delete bTree;
+		return NULL;
+	}
+
+	return bTree;
+}
+
+
+//---------------------------------------------------------------
+// Index stamps.
+//
+// The number of records a join index holds is kept on a page of
+// its own, registered in the DB file directory under the name of
+// the index followed by INDEX_STAMP_SUFFIX.
+//---------------------------------------------------------------
+
+#define INDEX_STAMP_SUFFIX ".count"
+
+static void IndexStampName(char* stampName, const char* indexName)
+{
+	sprintf(stampName, "%s%s", indexName, INDEX_STAMP_SUFFIX);
+}
+
+
+// The record count of the index, FAIL if it has no stamp
+static Status ReadIndexStamp(const char* indexName, int& numOfRecords)
+{
+	char stampName[MAX_INDEX_NAME_LENGTH + sizeof(INDEX_STAMP_SUFFIX)];
+	IndexStampName(stampName, indexName);
+
+	PageID stampPid;
+	Page* page;
+	if (OK != MINIBASE_DB->GetFileEntry(stampName, stampPid) || OK != MINIBASE_BM->PinPage(stampPid, page))
+	{
+		return FAIL;
+	}
+
+	memcpy(&numOfRecords, (char*)page, sizeof(int));
+	MINIBASE_BM->UnpinPage(stampPid, FALSE);
+
+	return OK;
+}
+
+
+// Set the record count of the index, adding the stamp if it has none
+static Status WriteIndexStamp(const char* indexName, int numOfRecords)
+{
+	char stampName[MAX_INDEX_NAME_LENGTH + sizeof(INDEX_STAMP_SUFFIX)];
+	IndexStampName(stampName, indexName);
+
+	PageID stampPid;
+	Page* page;
+	if (OK == MINIBASE_DB->GetFileEntry(stampName, stampPid))
+	{
+		if (OK != MINIBASE_BM->PinPage(stampPid, page))
+		{
+			return FAIL;
+		}
+	}
+	else
+	{
+		if (OK != MINIBASE_BM->NewPage(stampPid, page))
+		{
+			return FAIL;
+		}
+		if (OK != MINIBASE_DB->AddFileEntry(stampName, stampPid))
+		{
+			MINIBASE_BM->UnpinPage(stampPid, FALSE);
+			MINIBASE_BM->FreePage(stampPid);
+			return FAIL;
+		}
+	}
+
+	memcpy((char*)page, &numOfRecords, sizeof(int));
+	return MINIBASE_BM->UnpinPage(stampPid, TRUE);
+}
+
+
+// Drop the stamp of the index, if it has one
+static void DeleteIndexStamp(const char* indexName)
+{
+	char stampName[MAX_INDEX_NAME_LENGTH + sizeof(INDEX_STAMP_SUFFIX)];
+	IndexStampName(stampName, indexName);
+
+	PageID stampPid;
+	if (OK == MINIBASE_DB->GetFileEntry(stampName, stampPid))
+	{
+		MINIBASE_DB->DeleteFileEntry(stampName);
+		MINIBASE_BM->FreePage(stampPid);
+	}
+}
+
+
+// Add delta to the record count of the index. An index whose count
+// cannot be updated loses its stamp, so that it is rebuilt.
+static void AdjustIndexStamp(const char* indexName, int delta)
+{
+	int numOfRecords;
+	if (OK != ReadIndexStamp(indexName, numOfRecords) || OK != WriteIndexStamp(indexName, numOfRecords + delta))
+	{
+		DeleteIndexStamp(indexName);
+	}
+}
+
+
+//---------------------------------------------------------------
+// BuildPersistedIndex
+//
+// Purpose : Build the index named by spec.indexName and stamp it
+//           with the number of records of the relation.
+// Return  : The open index, or NULL on failure.
+//---------------------------------------------------------------
+
+static BTreeFile* BuildPersistedIndex(JoinSpec spec)
+{
+	int numOfRecords = spec.file->GetNumOfRecords();
+
+	BTreeFile* bTree = BuildJoinIndex(spec, spec.indexName);
+	if (NULL == bTree)
+	{
+		return NULL;
+	}
+
+	if (OK != WriteIndexStamp(spec.indexName, numOfRecords))
+	{
+		cerr << "ERROR: cannot record the size of the B+-tree " << spec.indexName << ".\n";
+		bTree->DestroyFile();
+		delete bTree;
+		return NULL;
+	}
+
+	return bTree;
+}
+
+
+//---------------------------------------------------------------
+// IndexMatchesRelation
+//
+// Purpose : Check that an existing B+-tree can serve as the join
+//           index of the relation: its keys must have the type and
+//           size of the relation's index keys, and its first entry
+//           must name a record of the relation with that key. A
+//           tree left under the same name by another relation or
+//           schema fails the check.
+//---------------------------------------------------------------
+
+static bool IndexMatchesRelation(BTreeFile* bTree, JoinSpec spec)
+{
+	AttrType keyType = (KEY_STRING == spec.keyType) ? ATTR_STRING : ATTR_INT;
+	if (keyType != bTree->GetKeyType() || IndexKeyLen(spec) != bTree->GetKeySize())
+	{
+		return false;
+	}
+
+	BTreeFileScan* scan = (BTreeFileScan*)bTree->OpenScan();
+	if (NULL == scan)
+	{
+		return false;
+	}
+
+	bool matches = true;
+
+	RecordID rid;
+	char key[MAX_STRING_KEY_LEN+1];
+	if (OK == scan->GetNext(rid, key))
+	{
+		int recLen = spec.recLen;
+		char* rec = new char[recLen];
+		char recKey[MAX_STRING_KEY_LEN+1];
+
+		matches = (OK == spec.file->GetRecord(rid, rec, recLen) && spec.recLen == recLen);
+		if (matches)
+		{
+			MakeIndexKey(recKey, rec, spec);
+			matches = (KEY_STRING == spec.keyType) ? (0 == strcmp(key, recKey)) : (0 == memcmp(key, recKey, sizeof(int)));
+		}
+
+		delete[] rec;
+	}
+	delete scan;
+
+	return matches;
+}
+
+
+//---------------------------------------------------------------
+// OpenJoinIndex
+//
+// Purpose : Open the index named by spec.indexName, building it
+//           first if it is not in the DB file directory yet, and
+//           building it again if the number of records it holds
+//           differs from that of the relation, which was then
+//           changed without going through InsertIntoRelation and
+//           DeleteFromRelation.
+// Return  : The open index, or NULL on failure or if the file of
+//           that name is not an index on the join attribute of
+//           the relation (see IndexMatchesRelation).
+//---------------------------------------------------------------
+
+BTreeFile* OpenJoinIndex(JoinSpec spec)
+{
+	Status status = OK;
+
+	PageID headerPid;
+	if (OK != MINIBASE_DB->GetFileEntry(spec.indexName, headerPid))
+	{
+		DeleteIndexStamp(spec.indexName);
+		return BuildPersistedIndex(spec);
+	}
+
+	BTreeFile* bTree = new BTreeFile(status, spec.indexName);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot open the B+-tree " << spec.indexName << ".\n";
+		delete bTree;
+		return NULL;
+	}
+
+	if (!IndexMatchesRelation(bTree, spec))
+	{
+		cerr << "ERROR: " << spec.indexName << " is not an index on the join attribute of relation " << spec.relName << ".\n";
+		delete bTree;
+		return NULL;
+	}
+
+	int numOfIndexedRecords;
+	if (OK != ReadIndexStamp(spec.indexName, numOfIndexedRecords) || spec.file->GetNumOfRecords() != numOfIndexedRecords)
+	{
+		if (OK != bTree->DestroyFile())
+		{
+			cerr << "ERROR: cannot drop the stale B+-tree " << spec.indexName << ".\n";
+			delete bTree;
+			return NULL;
+		}
+		delete bTree;
+
+		return BuildPersistedIndex(spec);
+	}
+
+	return bTree;
+}
+
+
+//---------------------------------------------------------------
+// InsertIntoRelation / DeleteFromRelation
+//
+// Purpose : Insert a record into (delete a record from) the heap
+//           file of a relation, keeping its join index, if one has
+//           been built, and the index's record count up to date.
+//           If the index cannot be updated, the heap file is left
+//           as it was.
+//---------------------------------------------------------------
+
+Status InsertIntoRelation(JoinSpec spec, char* recPtr, RecordID& outRid)
+{
+	Status status = spec.file->InsertRecord(recPtr, spec.recLen, outRid);
+	if (OK != status || '\0' == spec.indexName[0])
+	{
+		return status;
+	}
+
+	PageID headerPid;
+	if (OK != MINIBASE_DB->GetFileEntry(spec.indexName, headerPid))
+	{
+		return OK; // the index has not been built yet
+	}
+
+	char key[MAX_STRING_KEY_LEN+1];
+	MakeIndexKey(key, recPtr, spec);
+
+	BTreeFile* bTree = new BTreeFile(status, spec.indexName);
+	if (OK == status)
+	{
+		status = bTree->Insert(key, outRid);
+	}
+	delete bTree;
+
+	if (OK != status)
+	{
+		spec.file->DeleteRecord(outRid);
+		return FAIL;
+	}
+
+	AdjustIndexStamp(spec.indexName, 1);
+	return OK;
+}
+
+Status DeleteFromRelation(JoinSpec spec, const RecordID& rid)
+{
+	Status status = OK;
+
+	PageID headerPid;
+	if ('\0' == spec.indexName[0] || OK != MINIBASE_DB->GetFileEntry(spec.indexName, headerPid))
+	{
+		return spec.file->DeleteRecord(rid);
+	}
+
+	// The key is needed to locate the index entry
+	int recLen = spec.recLen;
+	char* rec = new char[recLen];
+
+	status = spec.file->GetRecord(rid, rec, recLen);
+	if (OK != status)
+	{
+		delete[] rec;
+		return status;
+	}
+
+	char key[MAX_STRING_KEY_LEN+1];
+	MakeIndexKey(key, rec, spec);
+	delete[] rec;
+
+	BTreeFile* bTree = new BTreeFile(status, spec.indexName);
+	if (OK == status)
+	{
+		status = bTree->Delete(key, rid);
+	}
+
+	if (OK == status && OK != spec.file->DeleteRecord(rid))
+	{
+		// Put the index entry back
+		bTree->Insert(key, rid);
+		status = FAIL;
+	}
+	delete bTree;
+
+	if (OK == status)
+	{
+		AdjustIndexStamp(spec.indexName, -1);
+	}
+
+	return status;
+}
@@ -0,0 +1,308 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../include/minirel.h"
+#include "../include/db.h"
+#include "../include/bufmgr.h"
+#include "../include/heapfile.h"
+#include "../include/heappage.h"
+#include "../include/join.h"
+
+
+//---------------------------------------------------------------
+// Cost-based choice of the join algorithm.
+//
+// Join() estimates the number of page I/Os of every algorithm that
+// supports the join predicate and key type, from the cardinality
+// and the page count of each relation and the frames the buffer
+// manager has free, and runs the cheapest. The page count is
+// derived from the cardinality and the record length, as the
+// relations of a join are plain heap files with no catalog entry.
+// All algorithms write the same result, so its cost is left out of
+// the comparison; the expected number of result records is logged
+// with the plan.
+//---------------------------------------------------------------
+
+// Frames the default buffer sizes of the joins leave to scans (3 * 3)
+#define PLAN_RESERVED_FRAMES 9
+
+// Selectivity of non-equality predicates, following System R
+#define INEQUALITY_SELECTIVITY (1.0 / 3.0)
+#define BAND_SELECTIVITY       (1.0 / 10.0)
+
+
+// Frames available to the blocks, batches and sort runs of a join
+static int JoinFrames()
+{
+	int numOfFrames = MINIBASE_BM->GetNumOfUnpinnedBuffers() - PLAN_RESERVED_FRAMES;
+	return (numOfFrames < 1) ? 1 : numOfFrames;
+}
+
+
+struct RelationStats
+{
+	double numOfRecords;
+	double numOfPages;
+};
+
+static RelationStats GetRelationStats(const JoinSpec &spec)
+{
+	RelationStats stats;
+
+	int recordsPerPage = HEAPPAGE_DATA_SIZE / (spec.recLen + SLOT_SIZE);
+	if (recordsPerPage < 1)
+	{
+		recordsPerPage = 1;
+	}
+
+	stats.numOfRecords = spec.file->GetNumOfRecords();
+	stats.numOfPages = ceil(stats.numOfRecords / recordsPerPage);
+	if (stats.numOfPages < 1)
+	{
+		stats.numOfPages = 1;
+	}
+
+	return stats;
+}
+
+
+// Fraction of all pairs of R and S records that satisfy the join
+// predicate, assuming that equi-joins follow a key - foreign key
+// relationship in which the smaller relation holds the keys
+static double JoinSelectivity(const JoinSpec &specOfR, const RelationStats &statsOfR, const RelationStats &statsOfS)
+{
+	double numOfKeys = (statsOfR.numOfRecords < statsOfS.numOfRecords) ? statsOfR.numOfRecords : statsOfS.numOfRecords;
+	double equalitySelectivity = (numOfKeys > 1) ? 1 / numOfKeys : 1;
+
+	switch (specOfR.joinOp)
+	{
+		case aopEQ:   return equalitySelectivity;
+		case aopNE:   return 1 - equalitySelectivity;
+		case opRANGE: return BAND_SELECTIVITY;
+		default:      return INEQUALITY_SELECTIVITY;
+	}
+}
+
+
+// Whether the index nested loop join probes the index with sorted
+// batches of R (the three-argument IndexNestedLoopJoin) rather than
+// once per R record: only for int keys under predicates other than
+// aopNE, whose matches form an interval of a sorted batch
+static bool BatchedIndexProbes(const JoinSpec &specOfR)
+{
+	return (KEY_INT == specOfR.keyType && aopNE != specOfR.joinOp);
+}
+
+
+// Page I/Os of sorting a relation of numOfPages pages the way
+// SortFile does: one pass writing runs of numOfFrames pages, merge
+// passes of fan-in numOfFrames / 2, and the final merge written out
+static double SortCost(double numOfPages, int numOfFrames)
+{
+	double numOfRuns = ceil(numOfPages / numOfFrames);
+	int fanIn = (numOfFrames / 2 < 2) ? 2 : numOfFrames / 2;
+
+	double numOfMergePasses = 0;
+	while (numOfRuns > fanIn)
+	{
+		numOfRuns = ceil(numOfRuns / fanIn);
+		numOfMergePasses++;
+	}
+
+	// Read and write the relation in pass 0, in every merge pass and
+	// in the final merge (unless it already fits into one run)
+	double numOfPasses = 1 + numOfMergePasses + ((numOfRuns > 1) ? 1 : 0);
+	return 2 * numOfPages * numOfPasses;
+}
+
+
+//---------------------------------------------------------------
+// EstimateJoinCosts
+//
+// Purpose : Estimate the page I/Os of every join algorithm for the
+//           given relations, and the number of result records.
+// Output  : costs - indexed by JoinAlgorithm; a negative cost marks
+//                   an algorithm that does not support the join
+//                   (it would fall back to another one).
+//---------------------------------------------------------------
+
+static void EstimateJoinCosts(JoinSpec specOfR, JoinSpec specOfS, double* costs, double& numOfResults)
+{
+	RelationStats statsOfR = GetRelationStats(specOfR);
+	RelationStats statsOfS = GetRelationStats(specOfS);
+
+	double M = statsOfR.numOfPages, N = statsOfS.numOfPages;
+	double pR = statsOfR.numOfRecords, pS = statsOfS.numOfRecords;
+
+	int numOfFrames = JoinFrames();
+
+	double selectivity = JoinSelectivity(specOfR, statsOfR, statsOfS);
+	double numOfMatches = selectivity * pR * pS;
+
+	switch (specOfR.joinType)
+	{
+		case SEMI_JOIN:       numOfResults = (numOfMatches < pR) ? numOfMatches : pR; break;
+		case ANTI_JOIN:       numOfResults = (numOfMatches < pR) ? pR - numOfMatches : 0; break;
+		case LEFT_OUTER_JOIN: numOfResults = (numOfMatches > pR) ? numOfMatches : pR; break;
+		default:              numOfResults = numOfMatches; break;
+	}
+
+	// Tuple nested loops: S is scanned once per R record
+	costs[TUPLE_NESTED_LOOP] = M + pR * N;
+
+	// Block nested loops: S is scanned once per block of R
+	double numOfBlocks = ceil(M / numOfFrames);
+	costs[BLOCK_NESTED_LOOP] = M + numOfBlocks * N;
+
+	// Index nested loops: the index is built (unless it is persisted
+	// already) by scanning S and writing the leaves. A batch of R sweeps
+	// the leaves between its smallest and largest key, which for an
+	// unordered R is most of them, and fetches the matching S records
+	// in page order; single probes descend the tree and fetch one page
+	// per match.
+	bool indexable = (KEY_INT == specOfR.keyType || (KEY_STRING == specOfR.keyType && aopEQ == specOfR.joinOp));
+	if (indexable)
+	{
+		double entriesPerLeaf = floor(MINIBASE_PAGESIZE / (double)(IndexKeyLen(specOfS) + sizeof(RecordID)));
+		double numOfLeaves = ceil(pS / entriesPerLeaf);
+		double height = 1 + ((numOfLeaves > 1) ? ceil(log(numOfLeaves) / log(entriesPerLeaf)) : 0);
+
+		PageID headerPid;
+		bool persisted = ('\0' != specOfS.indexName[0] && OK == MINIBASE_DB->GetFileEntry(specOfS.indexName, headerPid));
+		double buildCost = persisted ? 0 : N + numOfLeaves;
+
+		if (BatchedIndexProbes(specOfR))
+		{
+			double fetchesPerBatch = numOfMatches / numOfBlocks;
+			if (fetchesPerBatch > N)
+			{
+				fetchesPerBatch = N;
+			}
+
+			costs[INDEX_NESTED_LOOP] = M + buildCost + numOfBlocks * (height + numOfLeaves + fetchesPerBatch);
+		}
+		else
+		{
+			costs[INDEX_NESTED_LOOP] = M + buildCost + pR * height + numOfMatches;
+		}
+	}
+	else
+	{
+		costs[INDEX_NESTED_LOOP] = -1;
+	}
+
+	// Hash join: R and S are partitioned (written and read again)
+	// unless R fits into memory
+	if (aopEQ == specOfR.joinOp)
+	{
+		costs[HASH] = (M <= numOfFrames) ? M + N : 3 * (M + N);
+	}
+	else
+	{
+		costs[HASH] = -1;
+	}
+
+	// Sort-merge join: both relations are checked for order, sorted
+	// and merged
+	if (aopEQ == specOfR.joinOp && KEY_INT == specOfR.keyType)
+	{
+		costs[SORT_MERGE] = (M + SortCost(M, numOfFrames)) + (N + SortCost(N, numOfFrames)) + M + N;
+	}
+	else
+	{
+		costs[SORT_MERGE] = -1;
+	}
+}
+
+
+static const char* JoinAlgorithmName(JoinAlgorithm algorithm)
+{
+	switch (algorithm)
+	{
+		case TUPLE_NESTED_LOOP: return "tuple nested loop";
+		case BLOCK_NESTED_LOOP: return "block nested loop";
+		case INDEX_NESTED_LOOP: return "index nested loop";
+		case HASH:              return "hash";
+		case SORT_MERGE:        return "sort-merge";
+		default:                return "cost-based";
+	}
+}
+
+
+//---------------------------------------------------------------
+// ChooseJoinAlgorithm
+//
+// Purpose : Pick the join algorithm with the smallest estimated
+//           cost, and log the plan and the estimates.
+// Output  : cost - estimated page I/Os of the chosen algorithm.
+//---------------------------------------------------------------
+
+JoinAlgorithm ChooseJoinAlgorithm(JoinSpec specOfR, JoinSpec specOfS, double& cost)
+{
+	double costs[COST_BASED];
+	double numOfResults;
+
+	EstimateJoinCosts(specOfR, specOfS, costs, numOfResults);
+
+	// The block nested loop join supports every join
+	JoinAlgorithm chosen = BLOCK_NESTED_LOOP;
+	for (int algorithm = 0; algorithm < COST_BASED; algorithm++)
+	{
+		if (costs[algorithm] >= 0 && costs[algorithm] < costs[chosen])
+		{
+			chosen = (JoinAlgorithm)algorithm;
+		}
+	}
+	cost = costs[chosen];
+
+	cout << "JOIN PLAN: " << JoinAlgorithmName(chosen)
+		<< ((INDEX_NESTED_LOOP != chosen) ? "" : (BatchedIndexProbes(specOfR) ? " (batched probes)" : " (single probes)")) << " join of " << specOfR.relName << " and " << specOfS.relName
+		<< " with " << MINIBASE_BM->GetNumOfUnpinnedBuffers() << " free frames, estimated cost " << cost
+		<< " page I/Os, " << numOfResults << " result records (";
+	for (int algorithm = 0; algorithm < COST_BASED; algorithm++)
+	{
+		cout << ((algorithm > 0) ? ", " : "") << JoinAlgorithmName((JoinAlgorithm)algorithm) << " ";
+		if (costs[algorithm] >= 0)
+		{
+			cout << costs[algorithm];
+		}
+		else
+		{
+			cout << "n/a";
+		}
+	}
+	cout << ")\n";
+
+	return chosen;
+}
+
+
+HeapFile* Join(JoinSpec specOfR, JoinSpec specOfS)
+{
+	if (!CheckJoinKeys(specOfR, specOfS))
+	{
+		return NULL;
+	}
+
+	double cost;
+	JoinAlgorithm algorithm = ChooseJoinAlgorithm(specOfR, specOfS, cost);
+
+	int B = JoinFrames() * MINIBASE_PAGESIZE;
+
+	switch (algorithm)
+	{
+		case TUPLE_NESTED_LOOP: return TupleNestedLoopJoin(specOfR, specOfS);
+		case INDEX_NESTED_LOOP:
+			// The variant whose cost was estimated
+			if (BatchedIndexProbes(specOfR))
+			{
+				return IndexNestedLoopJoin(specOfR, specOfS, B);
+			}
+			return IndexNestedLoopJoin(specOfR, specOfS);
+		case HASH:              return HashJoin(specOfR, specOfS, B);
+		case SORT_MERGE:        return SortMergeJoin(specOfR, specOfS);
+		default:                return BlockNestedLoopJoin(specOfR, specOfS, B);
+	}
+}
@@ -0,0 +1,747 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/minirel.h"
+#include "../include/heapfile.h"
+#include "../include/scan.h"
+#include "../include/join.h"
+#include "../include/joinkey.h"
+#include "../include/btfile.h"
+#include "../include/btfilescan.h"
+#include "../include/operator.h"
+#include "../include/heappagescan.h"
+
+
+//---------------------------------------------------------------
+// Pipelined versions of the scan and join methods.
+//
+// Each operator keeps the state of its loops between calls to
+// GetNext() instead of running them to completion, and hands back
+// one joined record at a time. A parent must be destroyed before
+// the operators it was given.
+//---------------------------------------------------------------
+
+
+//---------------------------------------------------------------
+// CheckOperatorSpecs
+//
+// Purpose : Check, when a join operator is opened, that it can
+//           compute the join the specs ask for: an inner join of
+//           KEY_INT attributes that CheckJoinKeys accepts.
+//---------------------------------------------------------------
+
+static bool CheckOperatorSpecs(const JoinSpec& specOfR, const JoinSpec& specOfS)
+{
+	if (INNER_JOIN != specOfR.joinType)
+	{
+		cerr << "ERROR: the join operators only compute inner joins.\n";
+		return false;
+	}
+
+	if (KEY_INT != specOfR.keyType)
+	{
+		cerr << "ERROR: the join operators only join int attributes.\n";
+		return false;
+	}
+
+	return CheckJoinKeys(specOfR, specOfS);
+}
+
+
+//---------------------------------------------------------------
+// AdvanceInput
+//
+// Purpose : Read the next record of a merge join input into rec,
+//           setting more to whether there was one.
+// Return  : OK, or FAIL if the input failed.
+//---------------------------------------------------------------
+
+static Status AdvanceInput(Operator* input, char* rec, bool& more)
+{
+	Status status = input->GetNext(rec);
+
+	more = (OK == status);
+	return (OK == status || DONE == status) ? OK : FAIL;
+}
+
+
+//---------------------------------------------------------------
+// HeapScanOperator
+//---------------------------------------------------------------
+
+HeapScanOperator::HeapScanOperator(HeapFile* file, int recLen) : file(file), scan(NULL)
+{
+	this->recLen = recLen;
+}
+
+HeapScanOperator::~HeapScanOperator()
+{
+	Close();
+}
+
+Status HeapScanOperator::Open()
+{
+	Status status = OK;
+
+	Close();
+
+	scan = file->OpenScan(status);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot open scan on the heap file.\n";
+		scan = NULL;
+		return FAIL;
+	}
+
+	return OK;
+}
+
+Status HeapScanOperator::GetNext(char* recPtr)
+{
+	RecordID rid;
+	int len = recLen;
+
+	if (NULL == scan)
+	{
+		return FAIL;
+	}
+
+	Status status = scan->GetNext(rid, recPtr, len);
+	if (OK != status && DONE != status)
+	{
+		cerr << "ERROR: cannot read the heap file.\n";
+		return FAIL;
+	}
+
+	return status;
+}
+
+void HeapScanOperator::Close()
+{
+	delete scan;
+	scan = NULL;
+}
+
+
+//---------------------------------------------------------------
+// TupleNestedLoopJoinOperator
+//---------------------------------------------------------------
+
+TupleNestedLoopJoinOperator::TupleNestedLoopJoinOperator(Operator* outer, JoinSpec specOfR, JoinSpec specOfS)
+	: outer(outer), specOfR(specOfR), specOfS(specOfS), recR(NULL), recS(NULL), scanS(NULL), hintS(ACCESS_NORMAL)
+{
+	recLen = JoinedRecLen(specOfR, specOfS);
+}
+
+TupleNestedLoopJoinOperator::~TupleNestedLoopJoinOperator()
+{
+	Close();
+}
+
+Status TupleNestedLoopJoinOperator::Open()
+{
+	Close();
+
+	if (!CheckOperatorSpecs(specOfR, specOfS))
+	{
+		return FAIL;
+	}
+
+	if (OK != outer->Open())
+	{
+		return FAIL;
+	}
+
+	recR = new char[specOfR.recLen];
+	hintS = HeapPageScan::ScanHint(specOfS.file, specOfS.recLen);
+
+	return OK;
+}
+
+Status TupleNestedLoopJoinOperator::GetNext(char* recPtr)
+{
+	Status status = OK;
+
+	RecordID ridS;
+
+	while (true)
+	{
+		if (NULL == scanS)
+		{
+			// Move on to the next outer record
+			status = outer->GetNext(recR);
+			if (OK != status)
+			{
+				return status;
+			}
+
+			scanS = new HeapPageScan(specOfS.file, status, hintS);
+			if (OK != status)
+			{
+				cerr << "ERROR: cannot open scan on the relation S heap file.\n";
+				delete scanS;
+				scanS = NULL;
+				return FAIL;
+			}
+		}
+
+		int* joinArgR = (int*)&recR[specOfR.offset];
+		int len;
+
+		while (OK == (status = scanS->GetNextRef(ridS, recS, len)))
+		{
+			const int* joinArgS = (const int*)&recS[specOfS.offset];
+
+			if (JoinKeysMatch(*joinArgR, *joinArgS, specOfR))
+			{
+				MakeJoinedRecord(recPtr, recR, recS, specOfR, specOfS);
+				return OK;
+			}
+		}
+
+		delete scanS;
+		scanS = NULL;
+
+		if (DONE != status)
+		{
+			cerr << "ERROR: cannot read the relation S.\n";
+			return FAIL;
+		}
+	}
+}
+
+void TupleNestedLoopJoinOperator::Close()
+{
+	delete scanS;
+	scanS = NULL;
+
+	delete[] recR;
+	recR = NULL;
+	recS = NULL;
+
+	outer->Close();
+}
+
+
+//---------------------------------------------------------------
+// BlockNestedLoopJoinOperator
+//---------------------------------------------------------------
+
+BlockNestedLoopJoinOperator::BlockNestedLoopJoinOperator(Operator* outer, JoinSpec specOfR, JoinSpec specOfS, int B)
+	: outer(outer), specOfR(specOfR), specOfS(specOfS),
+	  recBlockR(NULL), numOfRecordsInBlock(0), lastBlock(false), recS(NULL), scanS(NULL), hintS(ACCESS_NORMAL), nextRecordIndex(-1)
+{
+	recLen = JoinedRecLen(specOfR, specOfS);
+
+	recordsPerBlock = B / specOfR.recLen;
+	if (recordsPerBlock < 1)
+	{
+		recordsPerBlock = 1;
+	}
+}
+
+BlockNestedLoopJoinOperator::~BlockNestedLoopJoinOperator()
+{
+	Close();
+}
+
+Status BlockNestedLoopJoinOperator::Open()
+{
+	Close();
+
+	if (!CheckOperatorSpecs(specOfR, specOfS))
+	{
+		return FAIL;
+	}
+
+	if (OK != outer->Open())
+	{
+		return FAIL;
+	}
+
+	recBlockR = new char[recordsPerBlock * specOfR.recLen];
+	hintS = HeapPageScan::ScanHint(specOfS.file, specOfS.recLen);
+
+	numOfRecordsInBlock = 0;
+	lastBlock = false;
+	nextRecordIndex = -1;
+
+	return OK;
+}
+
+Status BlockNestedLoopJoinOperator::GetNext(char* recPtr)
+{
+	Status status = OK;
+
+	int recLenR = specOfR.recLen;
+
+	RecordID ridS;
+
+	while (true)
+	{
+		if (NULL == scanS)
+		{
+			// Fill the next block from the outer input
+			if (lastBlock)
+			{
+				return DONE;
+			}
+
+			int i;
+			for (i = 0; i < recordsPerBlock; i++)
+			{
+				status = outer->GetNext(recBlockR + i*recLenR);
+				if (OK != status)
+				{
+					lastBlock = true;
+					break;
+				}
+			}
+			numOfRecordsInBlock = i;
+
+			if (OK != status && DONE != status)
+			{
+				return FAIL;
+			}
+
+			if (0 == numOfRecordsInBlock)
+			{
+				return DONE;
+			}
+
+			scanS = new HeapPageScan(specOfS.file, status, hintS);
+			if (OK != status)
+			{
+				cerr << "ERROR: cannot open scan on the relation S heap file.\n";
+				delete scanS;
+				scanS = NULL;
+				return FAIL;
+			}
+			nextRecordIndex = -1;
+		}
+
+		if (-1 == nextRecordIndex)
+		{
+			int len;
+			status = scanS->GetNextRef(ridS, recS, len);
+			if (OK != status)
+			{
+				delete scanS;
+				scanS = NULL;
+
+				if (DONE != status)
+				{
+					cerr << "ERROR: cannot read the relation S.\n";
+					return FAIL;
+				}
+				continue;
+			}
+			nextRecordIndex = 0;
+		}
+
+		// Compare the current S record with the rest of the block
+		const int* joinArgS = (const int*)&recS[specOfS.offset];
+
+		while (nextRecordIndex < numOfRecordsInBlock)
+		{
+			char* currentRecordPtr = recBlockR + (nextRecordIndex++ * recLenR);
+			int* joinArgR = (int*)(currentRecordPtr + specOfR.offset);
+
+			if (JoinKeysMatch(*joinArgR, *joinArgS, specOfR))
+			{
+				MakeJoinedRecord(recPtr, currentRecordPtr, recS, specOfR, specOfS);
+				return OK;
+			}
+		}
+		nextRecordIndex = -1;
+	}
+}
+
+void BlockNestedLoopJoinOperator::Close()
+{
+	delete scanS;
+	scanS = NULL;
+
+	delete[] recBlockR;
+	recBlockR = NULL;
+	recS = NULL;
+
+	outer->Close();
+}
+
+
+//---------------------------------------------------------------
+// IndexNestedLoopJoinOperator
+//---------------------------------------------------------------
+
+IndexNestedLoopJoinOperator::IndexNestedLoopJoinOperator(Operator* outer, JoinSpec specOfR, JoinSpec specOfS)
+	: outer(outer), specOfR(specOfR), specOfS(specOfS),
+	  bTree(NULL), temporaryIndex(false), bTreeScan(NULL), recR(NULL), recS(NULL)
+{
+	recLen = JoinedRecLen(specOfR, specOfS);
+}
+
+IndexNestedLoopJoinOperator::~IndexNestedLoopJoinOperator()
+{
+	Close();
+}
+
+Status IndexNestedLoopJoinOperator::Open()
+{
+	Close();
+
+	if (!CheckOperatorSpecs(specOfR, specOfS))
+	{
+		return FAIL;
+	}
+
+	// Open the persisted index on the inner relation (S), or build a
+	// temporary one if the specification does not name an index
+	temporaryIndex = ('\0' == specOfS.indexName[0]);
+
+	bTree = temporaryIndex ? BuildJoinIndex(specOfS, "IJOP") : OpenJoinIndex(specOfS);
+	if (NULL == bTree)
+	{
+		cerr << "ERROR: cannot open the B+-tree index on the relation S.\n";
+		return FAIL;
+	}
+
+	if (OK != outer->Open())
+	{
+		Close();
+		return FAIL;
+	}
+
+	recR = new char[specOfR.recLen];
+	recS = new char[specOfS.recLen];
+
+	return OK;
+}
+
+Status IndexNestedLoopJoinOperator::GetNext(char* recPtr)
+{
+	Status status = OK;
+
+	int recLenS = specOfS.recLen;
+
+	RecordID ridS;
+	int key;
+
+	while (true)
+	{
+		if (NULL == bTreeScan)
+		{
+			// Move on to the next outer record
+			status = outer->GetNext(recR);
+			if (OK != status)
+			{
+				return status;
+			}
+
+			// Probe the range of S keys that can satisfy the join predicate
+			int lowKey, highKey;
+			if (!MatchingKeysOfS(*(int*)&recR[specOfR.offset], specOfR, lowKey, highKey))
+			{
+				continue;
+			}
+			bTreeScan = bTree->OpenSearchScan(&lowKey, &highKey);
+		}
+
+		int* joinArgR = (int*)&recR[specOfR.offset];
+		while (OK == (status = bTreeScan->GetNext(ridS, &key)))
+		{
+			if (JoinKeysMatch(*joinArgR, key, specOfR))
+			{
+				int len = recLenS;
+				if (OK != specOfS.file->GetRecord(ridS, recS, len))
+				{
+					cerr << "ERROR: cannot read a record of the relation S.\n";
+					return FAIL;
+				}
+
+				MakeJoinedRecord(recPtr, recR, recS, specOfR, specOfS);
+				return OK;
+			}
+		}
+
+		delete bTreeScan;
+		bTreeScan = NULL;
+
+		if (DONE != status)
+		{
+			cerr << "ERROR: cannot probe the B+-tree index on the relation S.\n";
+			return FAIL;
+		}
+	}
+}
+
+void IndexNestedLoopJoinOperator::Close()
+{
+	delete bTreeScan;
+	bTreeScan = NULL;
+
+	if (NULL != bTree)
+	{
+		if (temporaryIndex)
+		{
+			bTree->DestroyFile();
+		}
+		delete bTree;
+		bTree = NULL;
+	}
+
+	delete[] recR;
+	delete[] recS;
+	recR = NULL;
+	recS = NULL;
+
+	outer->Close();
+}
+
+
+//---------------------------------------------------------------
+// SortMergeJoinOperator
+//---------------------------------------------------------------
+
+SortMergeJoinOperator::SortMergeJoinOperator(Operator* left, Operator* right, JoinSpec specOfR, JoinSpec specOfS)
+	: left(left), right(right), specOfR(specOfR), specOfS(specOfS),
+	  recR(NULL), recS(NULL), moreR(false), moreS(false),
+	  groupS(NULL), groupSize(0), groupCapacity(0), groupIndex(-1)
+{
+	recLen = JoinedRecLen(specOfR, specOfS);
+}
+
+SortMergeJoinOperator::~SortMergeJoinOperator()
+{
+	Close();
+}
+
+Status SortMergeJoinOperator::Open()
+{
+	Close();
+
+	if (!CheckOperatorSpecs(specOfR, specOfS))
+	{
+		return FAIL;
+	}
+
+	if (aopEQ != specOfR.joinOp)
+	{
+		cerr << "ERROR: the merge join operator only computes equi-joins.\n";
+		return FAIL;
+	}
+
+	if (OK != left->Open())
+	{
+		return FAIL;
+	}
+
+	if (OK != right->Open())
+	{
+		left->Close();
+		return FAIL;
+	}
+
+	recR = new char[specOfR.recLen];
+	recS = new char[specOfS.recLen];
+
+	groupCapacity = 16;
+	groupS = new char[groupCapacity * specOfS.recLen];
+	groupSize = 0;
+	groupIndex = -1;
+
+	if (OK != AdvanceInput(left, recR, moreR) || OK != AdvanceInput(right, recS, moreS))
+	{
+		Close();
+		return FAIL;
+	}
+
+	return OK;
+}
+
+Status SortMergeJoinOperator::GetNext(char* recPtr)
+{
+	int recLenS = specOfS.recLen;
+
+	while (true)
+	{
+		if (-1 != groupIndex)
+		{
+			// Join the current R record with the rest of the group
+			if (groupIndex < groupSize)
+			{
+				MakeJoinedRecord(recPtr, recR, groupS + (groupIndex++ * recLenS), specOfR, specOfS);
+				return OK;
+			}
+
+			// Reuse the group for the following R records of the same key
+			int groupKey = *(int*)(groupS + specOfS.offset);
+
+			if (OK != AdvanceInput(left, recR, moreR))
+			{
+				return FAIL;
+			}
+			if (moreR && *(int*)&recR[specOfR.offset] == groupKey)
+			{
+				groupIndex = 0;
+				continue;
+			}
+			groupIndex = -1;
+		}
+
+		if (!moreR || !moreS)
+		{
+			return DONE;
+		}
+
+		int joinArgR = *(int*)&recR[specOfR.offset];
+		int joinArgS = *(int*)&recS[specOfS.offset];
+
+		if (joinArgR < joinArgS)
+		{
+			if (OK != AdvanceInput(left, recR, moreR))
+			{
+				return FAIL;
+			}
+		}
+		else if (joinArgR > joinArgS)
+		{
+			if (OK != AdvanceInput(right, recS, moreS))
+			{
+				return FAIL;
+			}
+		}
+		else
+		{
+			// Collect the run of S records with this key
+			groupSize = 0;
+			while (moreS && *(int*)&recS[specOfS.offset] == joinArgR)
+			{
+				if (groupSize == groupCapacity)
+				{
+					char* largerGroupS = new char[2 * groupCapacity * recLenS];
+					memcpy(largerGroupS, groupS, groupCapacity * recLenS);
+					delete[] groupS;
+
+					groupS = largerGroupS;
+					groupCapacity *= 2;
+				}
+
+				memcpy(groupS + groupSize * recLenS, recS, recLenS);
+				groupSize++;
+
+				if (OK != AdvanceInput(right, recS, moreS))
+				{
+					return FAIL;
+				}
+			}
+			groupIndex = 0;
+		}
+	}
+}
+
+void SortMergeJoinOperator::Close()
+{
+	delete[] recR;
+	delete[] recS;
+	delete[] groupS;
+	recR = NULL;
+	recS = NULL;
+	groupS = NULL;
+
+	groupSize = 0;
+	groupCapacity = 0;
+	groupIndex = -1;
+
+	left->Close();
+	right->Close();
+}
+
+
+//---------------------------------------------------------------
+// Materialize
+//
+// Purpose : Run an operator to completion and store its records.
+// Return  : A new temporary HeapFile, or NULL on failure.
+//---------------------------------------------------------------
+
+HeapFile* Materialize(Operator* op)
+{
+	Status status = OK;
+
+	HeapFile* file = new HeapFile(NULL, status);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot create a file for the operator output.\n";
+		delete file;
+		return NULL;
+	}
+
+	if (OK != op->Open())
+	{
+		file->DeleteFile();
+		delete file;
+		return NULL;
+	}
+
+	int recLen = op->RecLen();
+	char* rec = new char[recLen];
+	HeapFileAppender records(file, recLen);
+
+	Status opStatus;
+	while (OK == (opStatus = op->GetNext(rec)))
+	{
+		records.Append(rec);
+	}
+	status = records.Flush();
+
+	op->Close();
+	delete[] rec;
+
+	if (DONE != opStatus || OK != status)
+	{
+		cerr << ((DONE != opStatus) ? "ERROR: the operator failed.\n" : "ERROR: cannot write the operator output.\n");
+		file->DeleteFile();
+		delete file;
+		return NULL;
+	}
+
+	return file;
+}
+
+
+//---------------------------------------------------------------
+// CountRecords
+//
+// Purpose : Run an operator to completion, discarding its records.
+// Return  : The number of records produced, -1 on failure.
+//---------------------------------------------------------------
+
+int CountRecords(Operator* op)
+{
+	if (OK != op->Open())
+	{
+		return -1;
+	}
+
+	char* rec = new char[op->RecLen()];
+	int count = 0;
+
+	Status status;
+	while (OK == (status = op->GetNext(rec)))
+	{
+		count++;
+	}
+
+	op->Close();
+	delete[] rec;
+
+	if (DONE != status)
+	{
+		cerr << "ERROR: the operator failed.\n";
+		return -1;
+	}
+
+	return count;
+}
@@ -7,6 +7,8 @@
 #include "../include/relation.h"
 #include "../include/btfile.h"
 #include "../include/btfilescan.h"
+#include "../include/heappagescan.h"
+#include "../include/operator.h"
 
 void toString(const int n, char* str)
 {
@@ -104,6 +106,14 @@ CreateSpecForR (JoinSpec &spec)
 		exit(1);
 	}
 	spec.offset = spec.joinAttr*sizeof(int);
+	spec.keyType = KEY_INT;
+	spec.keyLen = sizeof(int);
+	strcpy(spec.indexName, ""); // R is only scanned
+	spec.numOfOutAttr = ALL_ATTR;
+	spec.joinType = INNER_JOIN;
+	spec.joinOp = aopEQ;
+	spec.bandWidth = 0;
+	spec.useBloomFilter = false;
 }
 
 
@@ -168,6 +178,14 @@ void CreateSpecForS (JoinSpec &spec)
 		exit(1);
 	}
 	spec.offset = spec.joinAttr*sizeof(int);
+	spec.keyType = KEY_INT;
+	spec.keyLen = sizeof(int);
+	strcpy(spec.indexName, "S_id"); // index on Project.id, built on first use
+	spec.numOfOutAttr = ALL_ATTR;
+	spec.joinType = INNER_JOIN;
+	spec.joinOp = aopEQ;
+	spec.bandWidth = 0;
+	spec.useBloomFilter = false;
 }
 
 //------------------------------------------------------------------
@@ -179,7 +197,7 @@ void PrintResult (HeapFile *RS, char *name, bool printToScreen)
 {
 	Status s;
 	FILE *f;
-	Scan *scan = RS->OpenScan(s);
+	HeapPageScan *scan = new HeapPageScan(RS, s);
 	if (s != OK)
 	{
 		cerr << "Cannot open scan on result HeapFile." << endl;
@@ -190,19 +208,62 @@ void PrintResult (HeapFile *RS, char *name, bool printToScreen)
 		cerr << "Cannot open file " << name << " for writing.\n";
 	}
 
-	EmployeeProject e;
+	const char *rec;
 	int len;
 	RecordID rid;
 
-	while (scan->GetNext(rid, (char *)&e, len) != DONE)
+	while (scan->GetNextRef(rid, rec, len) == OK)
 	{
-		fprintf(f, "%d %d %d\n", e.proj, e.projid, e.id);
-		if (printToScreen) printf("%d %d %d\n", e.proj, e.projid, e.id);
+		const EmployeeProject *e = (const EmployeeProject *)rec;
+		fprintf(f, "%d %d %d\n", e->proj, e->projid, e->id);
+		if (printToScreen) printf("%d %d %d\n", e->proj, e->projid, e->id);
 	}
 	fclose(f);
   delete scan;
 }
 
+//------------------------------------------------------------------
+// Same as above, for the joined records produced by an operator,
+// e.g. a SortOperator over a join result, so that they need not be
+// stored in a HeapFile first.
+//------------------------------------------------------------------
+
+void PrintResult (Operator *op, char *name, bool printToScreen)
+{
+	FILE *f = fopen(name, "w");
+	if (f == NULL)
+	{
+		cerr << "Cannot open file " << name << " for writing.\n";
+		return;
+	}
+
+	if (op->Open() != OK)
+	{
+		cerr << "Cannot open the operator producing the result." << endl;
+		fclose(f);
+		return;
+	}
+
+	int recLen = (op->RecLen() > (int)sizeof(EmployeeProject)) ? op->RecLen() : (int)sizeof(EmployeeProject);
+	char *rec = new char[recLen];
+
+	Status s;
+	while ((s = op->GetNext(rec)) == OK)
+	{
+		const EmployeeProject *e = (const EmployeeProject *)rec;
+		fprintf(f, "%d %d %d\n", e->proj, e->projid, e->id);
+		if (printToScreen) printf("%d %d %d\n", e->proj, e->projid, e->id);
+	}
+	if (s != DONE)
+	{
+		cerr << "The operator producing the result failed; " << name << " is incomplete." << endl;
+	}
+
+	op->Close();
+	delete[] rec;
+	fclose(f);
+}
+
 void PrintR (HeapFile *R, char *name)
 {
 	Status s;
@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/minirel.h"
+#include "../include/heapfile.h"
+#include "../include/scan.h"
+#include "../include/join.h"
+#include "../include/relation.h"
+
+
+//---------------------------------------------------------------
+// Sort-merge join.
+//
+// Both relations are brought into join attribute order (inputs
+// that are already sorted are detected with a single scan and
+// used as they are), and then merged. For every key present in
+// both relations the run of matching S records is buffered in
+// memory and joined with each R record of the same key, so
+// duplicate runs on both sides produce their full cross product.
+// R records passed over without finding their key in S are the
+// unmatched ones of anti and left outer joins.
+//---------------------------------------------------------------
+
+
+//---------------------------------------------------------------
+// IsFileSorted
+//
+// Purpose : Check whether the records of a relation are stored
+//           in non-decreasing order of the join attribute.
+// Output  : sorted - true if they are.
+// Return  : OK, or FAIL if the relation cannot be read.
+//---------------------------------------------------------------
+
+static Status IsFileSorted(JoinSpec spec, bool& sorted)
+{
+	Status status = OK;
+
+	Scan* scan = spec.file->OpenScan(status);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot open scan on the relation " << spec.relName << " heap file.\n";
+		delete scan;
+		return FAIL;
+	}
+
+	int recLen = spec.recLen;
+	char* rec = new char[recLen];
+	RecordID rid;
+
+	sorted = true;
+	bool first = true;
+	int previousKey = 0;
+
+	Status scanStatus;
+	while (OK == (scanStatus = scan->GetNext(rid, rec, recLen)))
+	{
+		int key = *(int*)&rec[spec.offset];
+		if (!first && key < previousKey)
+		{
+			sorted = false;
+			break;
+		}
+
+		previousKey = key;
+		first = false;
+	}
+
+	delete scan;
+	delete[] rec;
+
+	if (sorted && DONE != scanStatus)
+	{
+		cerr << "ERROR: cannot read the relation " << spec.relName << ".\n";
+		return FAIL;
+	}
+
+	return OK;
+}
+
+
+// Delete a temporary file made by the join, if any
+static void DeleteTemporaryFile(HeapFile* file)
+{
+	if (NULL != file)
+	{
+		file->DeleteFile();
+		delete file;
+	}
+}
+
+
+HeapFile* SortMergeJoin(JoinSpec specOfR, JoinSpec specOfS)
+{
+	Status status = OK;
+
+	if (!CheckJoinKeys(specOfR, specOfS))
+	{
+		return NULL;
+	}
+
+	// The merge only pairs up equal keys
+	if (aopEQ != specOfR.joinOp)
+	{
+		return BlockNestedLoopJoin(specOfR, specOfS);
+	}
+
+	// SortFile orders int keys only; equal keys of other types are hashed
+	if (KEY_INT != specOfR.keyType)
+	{
+		return HashJoin(specOfR, specOfS);
+	}
+
+	int recLenR = specOfR.recLen;
+	int recLenS = specOfS.recLen;
+	int recLenJoined = JoinedRecLen(specOfR, specOfS);
+
+	// Sort the inputs unless they are already in join attribute order.
+	// The sorted copies are deleted again on every way out.
+	bool sortedInputR, sortedInputS;
+	if (OK != IsFileSorted(specOfR, sortedInputR) || OK != IsFileSorted(specOfS, sortedInputS))
+	{
+		return NULL;
+	}
+
+	HeapFile* sortedCopyR = sortedInputR ? NULL : SortFile(specOfR.file, recLenR, specOfR.offset);
+	HeapFile* sortedCopyS = sortedInputS ? NULL : SortFile(specOfS.file, recLenS, specOfS.offset);
+	if ((!sortedInputR && NULL == sortedCopyR) || (!sortedInputS && NULL == sortedCopyS))
+	{
+		cerr << "ERROR: cannot sort the relations to join.\n";
+		DeleteTemporaryFile(sortedCopyR);
+		DeleteTemporaryFile(sortedCopyS);
+		return NULL;
+	}
+
+	HeapFile* sortedR = sortedInputR ? specOfR.file : sortedCopyR;
+	HeapFile* sortedS = sortedInputS ? specOfS.file : sortedCopyS;
+
+	// Create a HeapFile for join results
+	HeapFile* joinedFile = new HeapFile(NULL, status);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot create a file for the joined relation.\n";
+		delete joinedFile;
+		DeleteTemporaryFile(sortedCopyR);
+		DeleteTemporaryFile(sortedCopyS);
+		return NULL;
+	}
+
+	Scan* scanR = sortedR->OpenScan(status);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot open scan on the relation R heap file.\n";
+		DeleteTemporaryFile(joinedFile);
+		DeleteTemporaryFile(sortedCopyR);
+		DeleteTemporaryFile(sortedCopyS);
+		return NULL;
+	}
+
+	Scan* scanS = sortedS->OpenScan(status);
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot open scan on the relation S heap file.\n";
+		delete scanR;
+		DeleteTemporaryFile(joinedFile);
+		DeleteTemporaryFile(sortedCopyR);
+		DeleteTemporaryFile(sortedCopyS);
+		return NULL;
+	}
+
+	char* recR = new char[recLenR];
+	char* recS = new char[recLenS];
+	HeapFileAppender joinedRecords(joinedFile, recLenJoined);
+
+	// Buffer for the run of S records sharing the current key
+	int groupCapacity = 16;
+	char* groupS = new char[groupCapacity * recLenS];
+
+	RecordID ridR, ridS;
+
+	JoinType joinType = specOfR.joinType;
+	bool keepUnmatchedR = (ANTI_JOIN == joinType || LEFT_OUTER_JOIN == joinType);
+
+	// The merge goes on while both scans return records; anything but
+	// DONE from a scan fails the join
+	Status scanStatusR = scanR->GetNext(ridR, recR, recLenR);
+	Status scanStatusS = scanS->GetNext(ridS, recS, recLenS);
+
+	while (OK == scanStatusR && OK == scanStatusS)
+	{
+		int joinArgR = *(int*)&recR[specOfR.offset];
+		int joinArgS = *(int*)&recS[specOfS.offset];
+
+		if (joinArgR < joinArgS)
+		{
+			// No S record has this key
+			if (keepUnmatchedR)
+			{
+				MakeJoinedRecord(joinedRecords.NextRecord(), recR, NULL, specOfR, specOfS);
+			}
+			scanStatusR = scanR->GetNext(ridR, recR, recLenR);
+		}
+		else if (joinArgR > joinArgS)
+		{
+			scanStatusS = scanS->GetNext(ridS, recS, recLenS);
+		}
+		else
+		{
+			// Collect the run of S records with this key
+			int groupSize = 0;
+			while (OK == scanStatusS && *(int*)&recS[specOfS.offset] == joinArgR)
+			{
+				if (groupSize == groupCapacity)
+				{
+					char* largerGroupS = new char[2 * groupCapacity * recLenS];
+					memcpy(largerGroupS, groupS, groupCapacity * recLenS);
+					delete[] groupS;
+
+					groupS = largerGroupS;
+					groupCapacity *= 2;
+				}
+
+				memcpy(groupS + groupSize * recLenS, recS, recLenS);
+				groupSize++;
+
+				scanStatusS = scanS->GetNext(ridS, recS, recLenS);
+			}
+
+			// Join every R record with this key with the whole run
+			while (OK == scanStatusR && *(int*)&recR[specOfR.offset] == joinArgR)
+			{
+				if (SEMI_JOIN == joinType)
+				{
+					MakeJoinedRecord(joinedRecords.NextRecord(), recR, NULL, specOfR, specOfS);
+				}
+				else if (ANTI_JOIN != joinType)
+				{
+					for (int i = 0; i < groupSize; i++)
+					{
+						MakeJoinedRecord(joinedRecords.NextRecord(), recR, groupS + i * recLenS, specOfR, specOfS);
+					}
+				}
+
+				scanStatusR = scanR->GetNext(ridR, recR, recLenR);
+			}
+		}
+	}
+
+	// R records beyond the last S key have no match
+	while (OK == scanStatusR && DONE == scanStatusS && keepUnmatchedR)
+	{
+		MakeJoinedRecord(joinedRecords.NextRecord(), recR, NULL, specOfR, specOfS);
+		scanStatusR = scanR->GetNext(ridR, recR, recLenR);
+	}
+
+	// Write out the buffered results
+	status = joinedRecords.Flush();
+
+	// A scan stopped by anything but the end of its relation leaves the
+	// result incomplete
+	bool readFailed = (OK != scanStatusR && DONE != scanStatusR) || (OK != scanStatusS && DONE != scanStatusS);
+
+	// Release the allocated resources
+	delete scanR;
+	delete scanS;
+
+	DeleteTemporaryFile(sortedCopyR);
+	DeleteTemporaryFile(sortedCopyS);
+
+	delete[] recR;
+	delete[] recS;
+	delete[] groupS;
+
+	if (readFailed)
+	{
+		cerr << "ERROR: cannot read the relations to join.\n";
+		DeleteTemporaryFile(joinedFile);
+		return NULL;
+	}
+
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot write the joined relation.\n";
+		DeleteTemporaryFile(joinedFile);
+		return NULL;
+	}
+
+	return joinedFile;
+}
@@ -0,0 +1,492 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/minirel.h"
+#include "../include/heapfile.h"
+#include "../include/scan.h"
+#include "../include/bufmgr.h"
+#include "../include/operator.h"
+
+
+//--------------------------------------------------------------------
+// External merge sort
+//
+// Pass 0 reads as many records as fit into the free buffer frames,
+// sorts them in memory and writes each such run into a temporary
+// HeapFile. The runs are then merged k at a time, where the fan-in k
+// is chosen so that every open run keeps its current pages resident,
+// until at most k runs remain. The last merge is not written out but
+// performed as the records are requested. Records with equal keys
+// keep their original relative order.
+//--------------------------------------------------------------------
+
+// Frames kept aside for the input and the consumer of the output
+#define SORT_RESERVED_FRAMES 4
+
+// Frames pinned by an open Scan (directory page + data page)
+#define SORT_FRAMES_PER_RUN 2
+
+
+struct SortEntry
+{
+	int key;            // sort key of the record
+	int keyLen;         // most bytes of string compared
+	const char* string; // string sort key in the run buffer, NULL for integer keys
+	int index;          // position of the record in the run buffer
+};
+
+static int CompareSortEntries(const void* a, const void* b)
+{
+	const SortEntry* entryA = (const SortEntry*)a;
+	const SortEntry* entryB = (const SortEntry*)b;
+
+	if (entryA->string != NULL)
+	{
+		int order = strncmp(entryA->string, entryB->string, entryA->keyLen);
+		if (order != 0)
+		{
+			return order;
+		}
+	}
+	else if (entryA->key != entryB->key)
+	{
+		return (entryA->key < entryB->key) ? -1 : 1;
+	}
+	return entryA->index - entryB->index;
+}
+
+
+// Whether the current record of runA comes before that of runB; ties
+// are broken by run number
+bool SortOperator::RunPrecedes(int runA, int runB)
+{
+	if (keyType == ATTR_STRING)
+	{
+		int order = strncmp(currentRecs + runA*recLen + offset, currentRecs + runB*recLen + offset, keyLen);
+		return order < 0 || (order == 0 && runA < runB);
+	}
+	return keys[runA] < keys[runB] || (keys[runA] == keys[runB] && runA < runB);
+}
+
+// Restore the heap property below position parent of the heap of
+// run numbers
+void SortOperator::SiftDown(int parent)
+{
+	while (true)
+	{
+		int smallest = parent;
+		for (int child = 2*parent + 1; child <= 2*parent + 2 && child < heapSize; child++)
+		{
+			if (RunPrecedes(heap[child], heap[smallest]))
+			{
+				smallest = child;
+			}
+		}
+
+		if (smallest == parent)
+		{
+			return;
+		}
+
+		int temp = heap[parent];
+		heap[parent] = heap[smallest];
+		heap[smallest] = temp;
+		parent = smallest;
+	}
+}
+
+
+SortOperator::SortOperator(Operator* input, int offset, AttrType keyType, int keyLen)
+	: input(input), offset(offset), keyType(keyType), keyLen(keyLen),
+	  recBuffer(NULL), entries(NULL), numOfEntries(0), nextEntry(0),
+	  runs(NULL), numOfRuns(0), scans(NULL), currentRecs(NULL), keys(NULL), heap(NULL), heapSize(0), mergeWidth(0)
+{
+	recLen = input->RecLen();
+}
+
+SortOperator::~SortOperator()
+{
+	Close();
+}
+
+
+//--------------------------------------------------------------------
+// GenerateRuns
+//
+// Purpose  : Read the whole input in chunks of runSize records and
+//            sort each chunk. If the input fits into a single chunk
+//            it is kept in memory; otherwise every chunk is written
+//            into a temporary HeapFile (a run).
+// Return   : OK, or FAIL if the input fails or a run cannot be
+//            written. The runs written so far are left for Close().
+//--------------------------------------------------------------------
+
+Status SortOperator::GenerateRuns(int runSize)
+{
+	Status s = OK;
+
+	recBuffer = new char[runSize * recLen];
+	entries = new SortEntry[runSize];
+
+	int runCapacity = 16;
+	runs = new HeapFile*[runCapacity];
+	numOfRuns = 0;
+
+	bool lastRun = false;
+	while (!lastRun)
+	{
+		// Fill the run buffer
+		int i;
+		for (i = 0; i < runSize; i++)
+		{
+			char* recPtr = recBuffer + i*recLen;
+			s = input->GetNext(recPtr);
+			if (s == DONE)
+			{
+				lastRun = true;
+				break;
+			}
+			if (s != OK)
+			{
+				cerr << "ERROR : cannot read the input of the sort.\n";
+				return FAIL;
+			}
+
+			entries[i].key = (keyType == ATTR_STRING) ? 0 : *(int*)(recPtr + offset);
+			entries[i].keyLen = keyLen;
+			entries[i].string = (keyType == ATTR_STRING) ? recPtr + offset : NULL;
+			entries[i].index = i;
+		}
+		numOfEntries = i;
+
+		qsort(entries, numOfEntries, sizeof(SortEntry), CompareSortEntries);
+
+		if (lastRun && numOfRuns == 0)
+		{
+			// Everything fits into memory
+			return OK;
+		}
+
+		if (numOfEntries == 0)
+		{
+			break;
+		}
+
+		// Write the run out in sorted order
+		HeapFile* run = new HeapFile(NULL, s);
+		if (s != OK)
+		{
+			cerr << "ERROR : cannot create a file for a sorted run.\n";
+			delete run;
+			return FAIL;
+		}
+
+		HeapFileAppender runRecords(run, recLen);
+		for (i = 0; i < numOfEntries; i++)
+		{
+			runRecords.Append(recBuffer + entries[i].index * recLen);
+		}
+		if (runRecords.Flush() != OK)
+		{
+			cerr << "ERROR : cannot write a sorted run.\n";
+			run->DeleteFile();
+			delete run;
+			return FAIL;
+		}
+
+		if (numOfRuns == runCapacity)
+		{
+			HeapFile** moreRuns = new HeapFile*[2 * runCapacity];
+			memcpy(moreRuns, runs, numOfRuns * sizeof(HeapFile*));
+			delete[] runs;
+
+			runs = moreRuns;
+			runCapacity *= 2;
+		}
+		runs[numOfRuns++] = run;
+	}
+
+	// The records now live in the runs
+	numOfEntries = 0;
+
+	return OK;
+}
+
+
+//--------------------------------------------------------------------
+// OpenMerge / NextMerged / CloseMerge
+//
+// Purpose  : Merge numOfRunsToMerge runs starting at firstRun using a
+//            binary heap over the current record of each run. Ties
+//            are broken by run number, which keeps the merge stable.
+//            A run that cannot be read fails the merge with FAIL.
+//--------------------------------------------------------------------
+
+Status SortOperator::OpenMerge(int firstRun, int numOfRunsToMerge)
+{
+	Status s = OK;
+
+	scans = new Scan*[numOfRunsToMerge];
+	currentRecs = new char[numOfRunsToMerge * recLen];
+	keys = new int[numOfRunsToMerge];
+	heap = new int[numOfRunsToMerge];
+	heapSize = 0;
+	mergeWidth = numOfRunsToMerge;
+
+	for (int run = 0; run < numOfRunsToMerge; run++)
+	{
+		scans[run] = NULL;
+	}
+
+	RecordID rid;
+
+	for (int run = 0; run < numOfRunsToMerge; run++)
+	{
+		scans[run] = runs[firstRun + run]->OpenScan(s);
+		if (s != OK)
+		{
+			cerr << "ERROR : cannot open scan on a sorted run.\n";
+			CloseMerge();
+			return FAIL;
+		}
+
+		int len = recLen;
+		s = scans[run]->GetNext(rid, currentRecs + run*recLen, len);
+		if (s == OK)
+		{
+			keys[run] = (keyType == ATTR_STRING) ? 0 : *(int*)(currentRecs + run*recLen + offset);
+			heap[heapSize++] = run;
+		}
+		else if (s != DONE)
+		{
+			cerr << "ERROR : cannot read a sorted run.\n";
+			CloseMerge();
+			return FAIL;
+		}
+	}
+
+	// Heapify
+	for (int i = heapSize / 2 - 1; i >= 0; i--)
+	{
+		SiftDown(i);
+	}
+
+	return OK;
+}
+
+Status SortOperator::NextMerged(char* recPtr)
+{
+	if (heapSize == 0)
+	{
+		return DONE;
+	}
+
+	int run = heap[0];
+	memcpy(recPtr, currentRecs + run*recLen, recLen);
+
+	// Advance the run, or drop it from the heap if exhausted
+	RecordID rid;
+	int len = recLen;
+	Status s = scans[run]->GetNext(rid, currentRecs + run*recLen, len);
+	if (s == OK)
+	{
+		keys[run] = (keyType == ATTR_STRING) ? 0 : *(int*)(currentRecs + run*recLen + offset);
+	}
+	else if (s == DONE)
+	{
+		heap[0] = heap[--heapSize];
+	}
+	else
+	{
+		cerr << "ERROR : cannot read a sorted run.\n";
+		return FAIL;
+	}
+
+	SiftDown(0);
+
+	return OK;
+}
+
+void SortOperator::CloseMerge()
+{
+	if (scans != NULL)
+	{
+		for (int run = 0; run < mergeWidth; run++)
+		{
+			delete scans[run];
+		}
+	}
+
+	delete[] scans;
+	delete[] currentRecs;
+	delete[] keys;
+	delete[] heap;
+
+	scans = NULL;
+	currentRecs = NULL;
+	keys = NULL;
+	heap = NULL;
+	heapSize = 0;
+	mergeWidth = 0;
+}
+
+Status SortOperator::MergeRuns(int firstRun, int numOfRunsToMerge, HeapFile* output)
+{
+	if (OpenMerge(firstRun, numOfRunsToMerge) != OK)
+	{
+		return FAIL;
+	}
+
+	char* recPtr = new char[recLen];
+	HeapFileAppender outputRecords(output, recLen);
+
+	Status mergeStatus;
+	while ((mergeStatus = NextMerged(recPtr)) == OK)
+	{
+		outputRecords.Append(recPtr);
+	}
+	Status s = outputRecords.Flush();
+
+	delete[] recPtr;
+	CloseMerge();
+
+	return (mergeStatus == DONE) ? s : FAIL;
+}
+
+
+Status SortOperator::Open()
+{
+	Status s = OK;
+
+	Close();
+
+	int numOfFrames = MINIBASE_BM->GetNumOfUnpinnedBuffers() - SORT_RESERVED_FRAMES;
+	if (numOfFrames < 1)
+	{
+		numOfFrames = 1;
+	}
+
+	int runSize = (numOfFrames * MINIBASE_PAGESIZE) / recLen;
+	if (runSize < 1)
+	{
+		runSize = 1;
+	}
+
+	int fanIn = numOfFrames / SORT_FRAMES_PER_RUN;
+	if (fanIn < 2)
+	{
+		fanIn = 2;
+	}
+
+	// Pass 0: produce sorted runs
+	if (input->Open() != OK)
+	{
+		return FAIL;
+	}
+	s = GenerateRuns(runSize);
+	input->Close();
+
+	if (s != OK)
+	{
+		Close();
+		return FAIL;
+	}
+
+	// Passes 1..n-1: merge fanIn runs at a time until the final
+	// merge can be done with one page per run
+	while (numOfRuns > fanIn)
+	{
+		int numOfMergedRuns = 0;
+		for (int firstRun = 0; firstRun < numOfRuns; firstRun += fanIn)
+		{
+			int runsInGroup = (numOfRuns - firstRun < fanIn) ? numOfRuns - firstRun : fanIn;
+
+			HeapFile* merged;
+			if (runsInGroup == 1)
+			{
+				merged = runs[firstRun];
+			}
+			else
+			{
+				merged = new HeapFile(NULL, s);
+				if (s != OK || MergeRuns(firstRun, runsInGroup, merged) != OK)
+				{
+					cerr << "ERROR : cannot merge sorted runs.\n";
+					if (s == OK)
+					{
+						merged->DeleteFile();
+					}
+					delete merged;
+
+					// Keep the runs that are still owned so that Close() deletes them
+					for (int run = firstRun; run < numOfRuns; run++)
+					{
+						runs[numOfMergedRuns++] = runs[run];
+					}
+					numOfRuns = numOfMergedRuns;
+					Close();
+					return FAIL;
+				}
+
+				for (int run = firstRun; run < firstRun + runsInGroup; run++)
+				{
+					runs[run]->DeleteFile();
+					delete runs[run];
+				}
+			}
+
+			runs[numOfMergedRuns++] = merged;
+		}
+		numOfRuns = numOfMergedRuns;
+	}
+
+	nextEntry = 0;
+
+	if (numOfRuns > 0 && OpenMerge(0, numOfRuns) != OK)
+	{
+		Close();
+		return FAIL;
+	}
+
+	return OK;
+}
+
+Status SortOperator::GetNext(char* recPtr)
+{
+	if (numOfRuns > 0)
+	{
+		return NextMerged(recPtr);
+	}
+
+	if (nextEntry == numOfEntries)
+	{
+		return DONE;
+	}
+
+	memcpy(recPtr, recBuffer + entries[nextEntry].index * recLen, recLen);
+	nextEntry++;
+
+	return OK;
+}
+
+void SortOperator::Close()
+{
+	CloseMerge();
+
+	for (int run = 0; run < numOfRuns; run++)
+	{
+		runs[run]->DeleteFile();
+		delete runs[run];
+	}
+	delete[] runs;
+	runs = NULL;
+	numOfRuns = 0;
+
+	delete[] recBuffer;
+	delete[] entries;
+	recBuffer = NULL;
+	entries = NULL;
+	numOfEntries = 0;
+	nextEntry = 0;
+}
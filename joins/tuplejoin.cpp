@@ -7,8 +7,10 @@
 #include "../include/heapfile.h"
 #include "../include/scan.h"
 #include "../include/join.h"
+#include "../include/joinkey.h"
 #include "../include/relation.h"
 #include "../include/bufmgr.h"
+#include "../include/heappagescan.h"
 
 
 //---------------------------------------------------------------
@@ -29,8 +31,9 @@
 //---------------------------------------------------------------
 
 
-
-HeapFile* TupleNestedLoopJoin(JoinSpec specOfR, JoinSpec specOfS)
+// The join for join keys of type Key (see joinkey.h)
+template <class Key>
+static HeapFile* TupleNestedLoopJoin(JoinSpec specOfR, JoinSpec specOfS)
 {
 	Status status = OK;
 
@@ -42,54 +45,101 @@ HeapFile* TupleNestedLoopJoin(JoinSpec specOfR, JoinSpec specOfS)
 	}
 
 
-	int recLenR = specOfR.recLen;
-	int recLenS = specOfS.recLen;
-	int recLenJoined = recLenR + recLenS;
+	int recLenR, recLenS;
+	int recLenJoined = JoinedRecLen(specOfR, specOfS);
+
+	JoinType joinType = specOfR.joinType;
+	int keyLen = specOfR.keyLen;
 
-	char* recR = new char[recLenR];
-	char* recS = new char[recLenS];
-	char* recJoined = new char[recLenJoined];
+	// The records are read in place on their pages (see HeapPageScan)
+	const char* recR;
+	const char* recS;
+	HeapFileAppender joinedRecords(joinedFile, recLenJoined);
 
-	RecordID ridR, ridS, ridJoined;
+	RecordID ridR, ridS;
+
+	// S is scanned once per record of R
+	AccessHint hintS = HeapPageScan::ScanHint(specOfS.file, specOfS.recLen);
 
 	// Join the relations
-	Scan* scanR = specOfR.file->OpenScan(status);
+	HeapPageScan* scanR = new HeapPageScan(specOfR.file, status);
 	if (OK != status)
 	{
 		cerr << "ERROR: cannot open scan on the relation R heap file.\n";
 		return NULL;
 	}
 
-	while (OK == scanR->GetNext(ridR, recR, recLenR))
+	while (OK == scanR->GetNextRef(ridR, recR, recLenR))
 	{
-		Scan* scanS = specOfS.file->OpenScan(status);
+		HeapPageScan* scanS = new HeapPageScan(specOfS.file, status, hintS);
 		if (OK != status)
 		{
 			cerr << "ERROR: cannot open scan on the relation S heap file.\n";
 			return NULL;
 		}
 
-		while (OK == scanS->GetNext(ridS, recS, recLenS))
+		typename Key::Value keyR = Key::Load(&recR[specOfR.offset], keyLen);
+
+		bool matched = false;
+		while (OK == scanS->GetNextRef(ridS, recS, recLenS))
 		{
-			int* joinArgR = (int*)&recR[specOfR.offset];
-			int* joinArgS = (int*)&recS[specOfS.offset];
+			typename Key::Value keyS = Key::Load(&recS[specOfS.offset], keyLen);
 
-			if (*joinArgR == *joinArgS)
+			if (KeysMatch<Key>(keyR, keyS, specOfR))
 			{
-				MakeNewRecord(recJoined, recR, recS, recLenR, recLenS);
-				joinedFile->InsertRecord(recJoined, recLenJoined, ridJoined);
+				matched = true;
+
+				if (ANTI_JOIN != joinType)
+				{
+					MakeJoinedRecord(joinedRecords.NextRecord(), recR, recS, specOfR, specOfS);
+				}
+
+				// One match decides a semi or anti join
+				if (SEMI_JOIN == joinType || ANTI_JOIN == joinType)
+				{
+					break;
+				}
 			}
 		}
 
 		delete scanS;
+
+		if (!matched && (ANTI_JOIN == joinType || LEFT_OUTER_JOIN == joinType))
+		{
+			MakeJoinedRecord(joinedRecords.NextRecord(), recR, NULL, specOfR, specOfS);
+		}
 	}
 
+	// Write out the buffered results
+	status = joinedRecords.Flush();
+
 	// Release the allocated resources
 	delete scanR;
 
-	delete[] recR;
-	delete[] recS;
-	delete[] recJoined;
+	if (OK != status)
+	{
+		cerr << "ERROR: cannot write the joined relation.\n";
+		joinedFile->DeleteFile();
+		delete joinedFile;
+		return NULL;
+	}
 
 	return joinedFile;
 }
+
+
+HeapFile* TupleNestedLoopJoin(JoinSpec specOfR, JoinSpec specOfS)
+{
+	if (!CheckJoinKeys(specOfR, specOfS))
+	{
+		return NULL;
+	}
+
+	switch (specOfR.keyType)
+	{
+		case KEY_INT64:     return TupleNestedLoopJoin<Int64JoinKey>(specOfR, specOfS);
+		case KEY_STRING:    return TupleNestedLoopJoin<StringJoinKey>(specOfR, specOfS);
+		case KEY_COMPOSITE: return TupleNestedLoopJoin<CompositeJoinKey>(specOfR, specOfS);
+		default:            return TupleNestedLoopJoin<IntJoinKey>(specOfR, specOfS);
+	}
+}
\ No newline at end of file
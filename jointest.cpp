@@ -5,16 +5,32 @@
 #include "include/bufmgr.h"
 #include "include/heapfile.h"
 #include "include/join.h"
+#include "include/btfile.h"
 #include "include/relation.h"
+#include "include/operator.h"
 #include "include/scan.h"
 
 #define NUM_OF_DB_PAGES  2000 // define # of DB pages
 #define NUM_OF_BUF_PAGES 50 // define Buf manager size.You will need to change this for the analysis
 
+#define STRING_KEY_LEN 5 // long enough for "k" and 4 digits, which leave no room for a NUL
+
+// Records of the relations with string join attributes
+typedef struct StringKeyed {
+	int  id;
+	char key[STRING_KEY_LEN];
+} StringKeyed;
+
 void PrintVerboseInfo(JoinSpec specOfS, JoinSpec specOfR, HeapFile* joinedFile);
 void SaveJoinedRelToFile(JoinSpec specOfR, JoinSpec specOfS, HeapFile* joinedFile, const char* resultFileNameString);
+void SaveProjectedRelToFile(JoinSpec specOfR, JoinSpec specOfS, HeapFile* joinedFile, const char* resultFileNameString);
+void SaveRecordsToFile(HeapFile* file, int recLen, const char* resultFileNameString);
+void TestJoinType(JoinSpec specOfR, JoinSpec specOfS, JoinType joinType, const char* joinTypeName);
+void CreateStringKeyedRelation(JoinSpec spec, int keyAttr, const char* relName, JoinSpec& stringSpec);
 int AreFilesEqual(const char* fileNameA, const char* fileNameB);
 int CountJoinedRecords(HeapFile* file);
+bool CheckJoinResult(HeapFile* joinedFile, const char* methodName, const char* resultFileName);
+
 
 int RunTests()
 {
@@ -48,23 +64,171 @@ int RunTests()
 	// File names for comparison
 	const char* nestedTupleFileName = "nestedTuple";
 	const char* nestedBlockFileName = "nestedBlock";
+	const char* nestedBlockHashFileName = "nestedBlockHash";
+	const char* nestedBlockPinnedFileName = "nestedBlockPinned";
 	const char* nestedIndexFileName = "nestedIndex";
+	const char* nestedIndexBatchedFileName = "nestedIndexBatched";
+	const char* reusedIndexFileName = "reusedIndex";
+	const char* updatedTupleFileName = "updatedTuple";
+	const char* staleIndexFileName = "staleIndex";
+	const char* changedTupleFileName = "changedTuple";
+	const char* hashFileName = "hash";
+	const char* sortMergeFileName = "sortMerge";
+	const char* pipelinedFileName = "pipelined";
+	const char* projectedFileName = "projected";
+	const char* costBasedFileName = "costBased";
 
 	// Join
 	HeapFile* tupleJoinedFile = TupleNestedLoopJoin(specOfR, specOfS);
-	//PrintVerboseInfo(specOfR, specOfS, tupleJoinedFile);
-	SaveJoinedRelToFile(specOfR, specOfS, tupleJoinedFile, nestedTupleFileName);
-	tupleJoinedFile->DeleteFile();
+	if (CheckJoinResult(tupleJoinedFile, "tuple nested loop", nestedTupleFileName))
+	{
+		//PrintVerboseInfo(specOfR, specOfS, tupleJoinedFile);
+		SaveJoinedRelToFile(specOfR, specOfS, tupleJoinedFile, nestedTupleFileName);
+		tupleJoinedFile->DeleteFile();
+	}
 
 	HeapFile* blockJoinedFile = BlockNestedLoopJoin(specOfR, specOfS, (MINIBASE_BM->GetNumOfUnpinnedBuffers() - 3 * 3) * MINIBASE_PAGESIZE);
-	//PrintVerboseInfo(specOfR, specOfS, blockJoinedFile);
-	SaveJoinedRelToFile(specOfR, specOfS, blockJoinedFile, nestedBlockFileName);
-	blockJoinedFile->DeleteFile();
+	if (CheckJoinResult(blockJoinedFile, "block nested loop", nestedBlockFileName))
+	{
+		//PrintVerboseInfo(specOfR, specOfS, blockJoinedFile);
+		SaveJoinedRelToFile(specOfR, specOfS, blockJoinedFile, nestedBlockFileName);
+		blockJoinedFile->DeleteFile();
+	}
+
+	HeapFile* blockHashJoinedFile = BlockNestedLoopJoin(specOfR, specOfS, (MINIBASE_BM->GetNumOfUnpinnedBuffers() - 3 * 3) * MINIBASE_PAGESIZE, PROBE_HASH);
+	if (CheckJoinResult(blockHashJoinedFile, "hashed block nested loop", nestedBlockHashFileName))
+	{
+		//PrintVerboseInfo(specOfR, specOfS, blockHashJoinedFile);
+		SaveJoinedRelToFile(specOfR, specOfS, blockHashJoinedFile, nestedBlockHashFileName);
+		blockHashJoinedFile->DeleteFile();
+	}
+
+	HeapFile* blockPinnedJoinedFile = BlockNestedLoopJoin(specOfR, specOfS, (MINIBASE_BM->GetNumOfUnpinnedBuffers() - 3 * 3) * MINIBASE_PAGESIZE, PROBE_SCAN, BLOCK_PINNED);
+	if (CheckJoinResult(blockPinnedJoinedFile, "pinned block nested loop", nestedBlockPinnedFileName))
+	{
+		//PrintVerboseInfo(specOfR, specOfS, blockPinnedJoinedFile);
+		SaveJoinedRelToFile(specOfR, specOfS, blockPinnedJoinedFile, nestedBlockPinnedFileName);
+		blockPinnedJoinedFile->DeleteFile();
+	}
 
 	HeapFile* indexJoinedFile = IndexNestedLoopJoin(specOfR, specOfS);
-	//PrintVerboseInfo(specOfR, specOfS, indexJoinedFile);
-	SaveJoinedRelToFile(specOfR, specOfS, indexJoinedFile, nestedIndexFileName);
-	indexJoinedFile->DeleteFile();
+	if (CheckJoinResult(indexJoinedFile, "index nested loop", nestedIndexFileName))
+	{
+		//PrintVerboseInfo(specOfR, specOfS, indexJoinedFile);
+		SaveJoinedRelToFile(specOfR, specOfS, indexJoinedFile, nestedIndexFileName);
+		indexJoinedFile->DeleteFile();
+	}
+
+	HeapFile* indexBatchedJoinedFile = IndexNestedLoopJoin(specOfR, specOfS, (MINIBASE_BM->GetNumOfUnpinnedBuffers() - 3 * 3) * MINIBASE_PAGESIZE);
+	if (CheckJoinResult(indexBatchedJoinedFile, "batched index nested loop", nestedIndexBatchedFileName))
+	{
+		//PrintVerboseInfo(specOfR, specOfS, indexBatchedJoinedFile);
+		SaveJoinedRelToFile(specOfR, specOfS, indexBatchedJoinedFile, nestedIndexBatchedFileName);
+		indexBatchedJoinedFile->DeleteFile();
+	}
+
+	HeapFile* hashJoinedFile = HashJoin(specOfR, specOfS);
+	if (CheckJoinResult(hashJoinedFile, "hash", hashFileName))
+	{
+		//PrintVerboseInfo(specOfR, specOfS, hashJoinedFile);
+		SaveJoinedRelToFile(specOfR, specOfS, hashJoinedFile, hashFileName);
+		hashJoinedFile->DeleteFile();
+	}
+
+	HeapFile* sortMergeJoinedFile = SortMergeJoin(specOfR, specOfS);
+	if (CheckJoinResult(sortMergeJoinedFile, "sort-merge", sortMergeFileName))
+	{
+		//PrintVerboseInfo(specOfR, specOfS, sortMergeJoinedFile);
+		SaveJoinedRelToFile(specOfR, specOfS, sortMergeJoinedFile, sortMergeFileName);
+		sortMergeJoinedFile->DeleteFile();
+	}
+
+	HeapFile* costBasedJoinedFile = Join(specOfR, specOfS);
+	if (CheckJoinResult(costBasedJoinedFile, "cost based", costBasedFileName))
+	{
+		SaveJoinedRelToFile(specOfR, specOfS, costBasedJoinedFile, costBasedFileName);
+		costBasedJoinedFile->DeleteFile();
+	}
+
+	// Sort both relations and merge join them without intermediate files
+	HeapScanOperator scanR(specOfR.file, specOfR.recLen);
+	HeapScanOperator scanS(specOfS.file, specOfS.recLen);
+	SortOperator sortR(&scanR, specOfR.offset);
+	SortOperator sortS(&scanS, specOfS.offset);
+	SortMergeJoinOperator mergeJoin(&sortR, &sortS, specOfR, specOfS);
+
+	HeapFile* pipelinedJoinedFile = Materialize(&mergeJoin);
+	if (CheckJoinResult(pipelinedJoinedFile, "pipelined sort-merge", pipelinedFileName))
+	{
+		SaveJoinedRelToFile(specOfR, specOfS, pipelinedJoinedFile, pipelinedFileName);
+		pipelinedJoinedFile->DeleteFile();
+	}
+
+	// Join keeping only the attributes that the result files show
+	JoinSpec projectedSpecOfR = specOfR;
+	JoinSpec projectedSpecOfS = specOfS;
+
+	projectedSpecOfR.numOfOutAttr = 2;
+	projectedSpecOfR.outAttr[0] = 0; // Employee.id
+	projectedSpecOfR.outAttr[1] = 2; // Employee.proj
+	projectedSpecOfS.numOfOutAttr = 1;
+	projectedSpecOfS.outAttr[0] = 0; // Project.id
+
+	HeapFile* projectedJoinedFile = HashJoin(projectedSpecOfR, projectedSpecOfS);
+	if (CheckJoinResult(projectedJoinedFile, "projected hash", projectedFileName))
+	{
+		SaveProjectedRelToFile(projectedSpecOfR, projectedSpecOfS, projectedJoinedFile, projectedFileName);
+		projectedJoinedFile->DeleteFile();
+	}
+
+	// The index join above built the persisted index on S; change S through
+	// the index maintaining interface and check that the index is reused
+	Project extraProject = { 0, 1000, 0, 0 };
+	RecordID extraRid;
+	InsertIntoRelation(specOfS, (char*)&extraProject, extraRid);
+	InsertIntoRelation(specOfS, (char*)&extraProject, extraRid);
+	DeleteFromRelation(specOfS, extraRid);
+
+	HeapFile* reusedIndexJoinedFile = IndexNestedLoopJoin(specOfR, specOfS);
+	if (CheckJoinResult(reusedIndexJoinedFile, "reused index nested loop", reusedIndexFileName))
+	{
+		SaveJoinedRelToFile(specOfR, specOfS, reusedIndexJoinedFile, reusedIndexFileName);
+		reusedIndexJoinedFile->DeleteFile();
+	}
+
+	HeapFile* updatedTupleJoinedFile = TupleNestedLoopJoin(specOfR, specOfS);
+	if (CheckJoinResult(updatedTupleJoinedFile, "updated tuple nested loop", updatedTupleFileName))
+	{
+		SaveJoinedRelToFile(specOfR, specOfS, updatedTupleJoinedFile, updatedTupleFileName);
+		updatedTupleJoinedFile->DeleteFile();
+	}
+
+	// A project inserted into S directly is not in the persisted index,
+	// which must be rebuilt rather than reused
+	Project directProject = { 1, 1000, 0, 0 };
+	specOfS.file->InsertRecord((char*)&directProject, sizeof(Project), extraRid);
+
+	HeapFile* staleIndexJoinedFile = IndexNestedLoopJoin(specOfR, specOfS);
+	if (CheckJoinResult(staleIndexJoinedFile, "stale index nested loop", staleIndexFileName))
+	{
+		SaveJoinedRelToFile(specOfR, specOfS, staleIndexJoinedFile, staleIndexFileName);
+		staleIndexJoinedFile->DeleteFile();
+	}
+
+	HeapFile* changedTupleJoinedFile = TupleNestedLoopJoin(specOfR, specOfS);
+	if (CheckJoinResult(changedTupleJoinedFile, "changed tuple nested loop", changedTupleFileName))
+	{
+		SaveJoinedRelToFile(specOfR, specOfS, changedTupleJoinedFile, changedTupleFileName);
+		changedTupleJoinedFile->DeleteFile();
+	}
+
+	// The persisted index must not be taken for an index on another key
+	JoinSpec stringKeyedSpecOfS = specOfS;
+	stringKeyedSpecOfS.keyType = KEY_STRING;
+	stringKeyedSpecOfS.keyLen = 2 * sizeof(int);
+
+	BTreeFile* mismatchedIndex = OpenJoinIndex(stringKeyedSpecOfS);
+	delete mismatchedIndex;
 
 	if (!AreFilesEqual(nestedTupleFileName, nestedBlockFileName))
 	{
@@ -75,6 +239,24 @@ int RunTests()
 		cerr << "FAIL: nested tuple join and nested block joins DO NOT yield equivalent results (see files " << nestedTupleFileName << ", " << nestedBlockFileName << ").\n";
 	}
 
+	if (!AreFilesEqual(nestedBlockFileName, nestedBlockHashFileName))
+	{
+		cout << "PASS: nested block join with scanned and hashed blocks yield equivalent results.\n";
+	}
+	else
+	{
+		cerr << "FAIL: nested block join with scanned and hashed blocks DO NOT yield equivalent results (see files " << nestedBlockFileName << ", " << nestedBlockHashFileName << ").\n";
+	}
+
+	if (!AreFilesEqual(nestedBlockFileName, nestedBlockPinnedFileName))
+	{
+		cout << "PASS: nested block join with copied and pinned blocks yield equivalent results.\n";
+	}
+	else
+	{
+		cerr << "FAIL: nested block join with copied and pinned blocks DO NOT yield equivalent results (see files " << nestedBlockFileName << ", " << nestedBlockPinnedFileName << ").\n";
+	}
+
 	if (!AreFilesEqual(nestedBlockFileName, nestedIndexFileName))
 	{
 		cout << "PASS: nested block join and nested index joins yield equivalent results.\n";
@@ -93,21 +275,459 @@ int RunTests()
 		cerr << "FAIL: nested index join and nested tuple joins DO NOT yield equivalent results (see files " << nestedIndexFileName << ", " << nestedTupleFileName << ").\n";
 	}
 
+	if (!AreFilesEqual(nestedIndexFileName, nestedIndexBatchedFileName))
+	{
+		cout << "PASS: nested index join with single and batched probes yield equivalent results.\n";
+	}
+	else
+	{
+		cerr << "FAIL: nested index join with single and batched probes DO NOT yield equivalent results (see files " << nestedIndexFileName << ", " << nestedIndexBatchedFileName << ").\n";
+	}
+
+	if (!AreFilesEqual(reusedIndexFileName, updatedTupleFileName))
+	{
+		cout << "PASS: nested index join with a maintained persisted index and nested tuple joins yield equivalent results.\n";
+	}
+	else
+	{
+		cerr << "FAIL: nested index join with a maintained persisted index and nested tuple joins DO NOT yield equivalent results (see files " << reusedIndexFileName << ", " << updatedTupleFileName << ").\n";
+	}
+
+	if (!AreFilesEqual(staleIndexFileName, changedTupleFileName))
+	{
+		cout << "PASS: nested index join after a direct change of the relation and nested tuple joins yield equivalent results.\n";
+	}
+	else
+	{
+		cerr << "FAIL: nested index join after a direct change of the relation and nested tuple joins DO NOT yield equivalent results (see files " << staleIndexFileName << ", " << changedTupleFileName << ").\n";
+	}
+
+	if (NULL == mismatchedIndex)
+	{
+		cout << "PASS: a persisted index on another key is not reused as the join index.\n";
+	}
+	else
+	{
+		cerr << "FAIL: a persisted index on another key is reused as the join index.\n";
+	}
+
+	if (!AreFilesEqual(hashFileName, nestedTupleFileName))
+	{
+		cout << "PASS: hash join and nested tuple joins yield equivalent results.\n";
+	}
+	else
+	{
+		cerr << "FAIL: hash join and nested tuple joins DO NOT yield equivalent results (see files " << hashFileName << ", " << nestedTupleFileName << ").\n";
+	}
+
+	if (!AreFilesEqual(sortMergeFileName, nestedTupleFileName))
+	{
+		cout << "PASS: sort-merge join and nested tuple joins yield equivalent results.\n";
+	}
+	else
+	{
+		cerr << "FAIL: sort-merge join and nested tuple joins DO NOT yield equivalent results (see files " << sortMergeFileName << ", " << nestedTupleFileName << ").\n";
+	}
+
+	if (!AreFilesEqual(costBasedFileName, nestedTupleFileName))
+	{
+		cout << "PASS: cost-based join and nested tuple joins yield equivalent results.\n";
+	}
+	else
+	{
+		cerr << "FAIL: cost-based join and nested tuple joins DO NOT yield equivalent results (see files " << costBasedFileName << ", " << nestedTupleFileName << ").\n";
+	}
+
+	if (!AreFilesEqual(pipelinedFileName, nestedTupleFileName))
+	{
+		cout << "PASS: pipelined sort-merge join and nested tuple joins yield equivalent results.\n";
+	}
+	else
+	{
+		cerr << "FAIL: pipelined sort-merge join and nested tuple joins DO NOT yield equivalent results (see files " << pipelinedFileName << ", " << nestedTupleFileName << ").\n";
+	}
+
+	if (!AreFilesEqual(projectedFileName, nestedTupleFileName))
+	{
+		cout << "PASS: projected hash join and nested tuple joins yield equivalent results.\n";
+	}
+	else
+	{
+		cerr << "FAIL: projected hash join and nested tuple joins DO NOT yield equivalent results (see files " << projectedFileName << ", " << nestedTupleFileName << ").\n";
+	}
+
+	// Remove every fifth project (including the duplicated project 0),
+	// so that some employees have no match, and check the join variants
+	Scan* projectScan = specOfS.file->OpenScan(s);
+	int numOfProjects = specOfS.file->GetNumOfRecords();
+	RecordID* removedRids = new RecordID[numOfProjects];
+	int numOfRemovedProjects = 0;
+
+	Project project;
+	int projectLen = sizeof(Project);
+	RecordID projectRid;
+	while (numOfRemovedProjects < numOfProjects && OK == projectScan->GetNext(projectRid, (char*)&project, projectLen))
+	{
+		if (0 == project.id % 5)
+		{
+			removedRids[numOfRemovedProjects++] = projectRid;
+		}
+	}
+	delete projectScan;
+
+	for (int i = 0; i < numOfRemovedProjects; i++)
+	{
+		DeleteFromRelation(specOfS, removedRids[i]);
+	}
+	delete[] removedRids;
+
+	TestJoinType(specOfR, specOfS, SEMI_JOIN, "semi");
+	TestJoinType(specOfR, specOfS, ANTI_JOIN, "anti");
+	TestJoinType(specOfR, specOfS, LEFT_OUTER_JOIN, "leftOuter");
+
+	// The same joins with R filtered by a Bloom filter over the projects
+	// left in S
+	JoinSpec filteredSpecOfR = specOfR;
+	filteredSpecOfR.useBloomFilter = true;
+
+	TestJoinType(filteredSpecOfR, specOfS, INNER_JOIN, "filtered");
+	TestJoinType(filteredSpecOfR, specOfS, ANTI_JOIN, "filteredAnti");
+	TestJoinType(filteredSpecOfR, specOfS, LEFT_OUTER_JOIN, "filteredLeftOuter");
+
+	// Band join of the employees' salaries with the projects' funds,
+	// probing a temporary index on Project.fund
+	JoinSpec bandSpecOfR = specOfR;
+	JoinSpec bandSpecOfS = specOfS;
+
+	bandSpecOfR.joinAttr = 3; // Employee.salary
+	bandSpecOfR.offset = 3 * sizeof(int);
+	bandSpecOfR.joinOp = opRANGE;
+	bandSpecOfR.bandWidth = 20;
+	bandSpecOfR.numOfOutAttr = 2;
+	bandSpecOfR.outAttr[0] = 0; // Employee.id
+	bandSpecOfR.outAttr[1] = 3; // Employee.salary
+
+	bandSpecOfS.joinAttr = 1; // Project.fund
+	bandSpecOfS.offset = sizeof(int);
+	bandSpecOfS.indexName[0] = '\0';
+	bandSpecOfS.numOfOutAttr = 2;
+	bandSpecOfS.outAttr[0] = 0; // Project.id
+	bandSpecOfS.outAttr[1] = 1; // Project.fund
+
+	TestJoinType(bandSpecOfR, bandSpecOfS, INNER_JOIN, "band");
+	TestJoinType(bandSpecOfR, bandSpecOfS, ANTI_JOIN, "bandAnti");
+
+	// Inequality join on a small domain
+	bandSpecOfR.joinOp = aopGT;
+	bandSpecOfR.joinAttr = 4; // Employee.rating
+	bandSpecOfR.offset = 4 * sizeof(int);
+	bandSpecOfR.outAttr[1] = 4;
+	bandSpecOfS.joinAttr = 3; // Project.status
+	bandSpecOfS.offset = 3 * sizeof(int);
+	bandSpecOfS.outAttr[1] = 3;
+
+	TestJoinType(bandSpecOfR, bandSpecOfS, SEMI_JOIN, "greaterSemi");
+
+	// Join the projects with the employees of a department of the same
+	// id, probing a temporary index on Employee.dept, which is bulk
+	// loaded with runs of about 330 duplicates of each of its 30 keys,
+	// every run spanning several leaves
+	JoinSpec deptSpecOfR = specOfR;
+	deptSpecOfR.joinAttr = 5; // Employee.dept
+	deptSpecOfR.offset = 5 * sizeof(int);
+
+	TestJoinType(specOfS, deptSpecOfR, INNER_JOIN, "duplicateKeys");
+
+	// Joins on (Employee.proj, Employee.salary) and (Project.id, Project.fund),
+	// as composite keys and as 64-bit keys
+	JoinSpec wideSpecOfR = specOfR;
+	JoinSpec wideSpecOfS = specOfS;
+
+	wideSpecOfR.offset = 2 * sizeof(int);
+	wideSpecOfR.keyType = KEY_COMPOSITE;
+	wideSpecOfR.keyLen = 2 * sizeof(int);
+	wideSpecOfS.offset = 0;
+	wideSpecOfS.keyType = KEY_COMPOSITE;
+	wideSpecOfS.keyLen = 2 * sizeof(int);
+
+	TestJoinType(wideSpecOfR, wideSpecOfS, INNER_JOIN, "composite");
+
+	wideSpecOfR.joinOp = aopLT;
+	TestJoinType(wideSpecOfR, wideSpecOfS, SEMI_JOIN, "compositeLessSemi");
+
+	wideSpecOfR.keyType = KEY_INT64;
+	wideSpecOfS.keyType = KEY_INT64;
+	wideSpecOfR.joinOp = opRANGE;
+	wideSpecOfR.bandWidth = 3;
+	TestJoinType(wideSpecOfR, wideSpecOfS, INNER_JOIN, "int64Band");
+
+	// Join Employee.proj and Project.id written out as strings
+	JoinSpec stringSpecOfR, stringSpecOfS;
+
+	CreateStringKeyedRelation(specOfR, 2, "RStr", stringSpecOfR); // Employee.proj
+	CreateStringKeyedRelation(specOfS, 0, "SStr", stringSpecOfS); // Project.id
+
+	TestJoinType(stringSpecOfR, stringSpecOfS, INNER_JOIN, "string");
+	TestJoinType(stringSpecOfR, stringSpecOfS, LEFT_OUTER_JOIN, "stringLeftOuter");
+
+	stringSpecOfR.joinOp = aopLT;
+	TestJoinType(stringSpecOfR, stringSpecOfS, SEMI_JOIN, "stringLessSemi");
+
+	stringSpecOfR.file->DeleteFile();
+	stringSpecOfS.file->DeleteFile();
+
 	return 0;
 }
 
 
+// Report a join method that returned no result, and write a result
+// file that matches no other, so that its comparisons fail as well
+bool CheckJoinResult(HeapFile* joinedFile, const char* methodName, const char* resultFileName)
+{
+	if (NULL != joinedFile)
+	{
+		return true;
+	}
+
+	cerr << "FAIL: the " << methodName << " join returned no result.\n";
+
+	FILE* f = fopen(resultFileName, "w");
+	if (NULL != f)
+	{
+		fprintf(f, "no result from the %s join\n", methodName);
+		fclose(f);
+	}
+	return false;
+}
+
+
 void SaveJoinedRelToFile(JoinSpec specOfR, JoinSpec specOfS, HeapFile* joinedFile, const char* resultFileNameString)
 {
 	char* resultFileName = new char[255];
 	strcpy(resultFileName, resultFileNameString);
 
-	HeapFile* sortedJoinedFile = SortFile(joinedFile, specOfR.recLen + specOfS.recLen, 0);
-	PrintResult(sortedJoinedFile, resultFileName, false);
+	// Print the records as they come out of the sort
+	HeapScanOperator scan(joinedFile, JoinedRecLen(specOfR, specOfS));
+	SortOperator sort(&scan, 0);
+	PrintResult(&sort, resultFileName, false);
+}
+
+
+// Same as SaveJoinedRelToFile, for join results that hold just
+// (Employee.id, Employee.proj, Project.id)
+void SaveProjectedRelToFile(JoinSpec specOfR, JoinSpec specOfS, HeapFile* joinedFile, const char* resultFileNameString)
+{
+	int recLen = JoinedRecLen(specOfR, specOfS);
+
+	HeapFile* sortedJoinedFile = SortFile(joinedFile, recLen, 0);
+	if (!CheckJoinResult(sortedJoinedFile, "sorted projected", resultFileNameString))
+	{
+		return;
+	}
+
+	Status status = OK;
+	Scan* scan = sortedJoinedFile->OpenScan(status);
+	if (status != OK)
+	{
+		cerr << "Cannot open scan on result HeapFile." << endl;
+		return;
+	}
+
+	FILE* f = fopen(resultFileNameString, "w");
+	if (f == NULL)
+	{
+		cerr << "Cannot open file " << resultFileNameString << " for writing.\n";
+		delete scan;
+		return;
+	}
+
+	int rec[3];
+	int len = recLen;
+	RecordID rid;
+
+	while (scan->GetNext(rid, (char *)rec, len) != DONE)
+	{
+		fprintf(f, "%d %d %d\n", rec[1], rec[2], rec[0]);
+	}
+	fclose(f);
+
+	delete scan;
 	sortedJoinedFile->DeleteFile();
 }
 
 
+// Number of attributes compared by CompareRecords
+static int numOfComparedAttr;
+
+static int CompareRecords(const void* a, const void* b)
+{
+	const int* recA = (const int*)a;
+	const int* recB = (const int*)b;
+
+	for (int i = 0; i < numOfComparedAttr; i++)
+	{
+		if (recA[i] != recB[i])
+		{
+			return (recA[i] < recB[i]) ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+
+// Save records of recLen bytes with all their (integer) attributes,
+// sorted on all attributes so that records with equal first
+// attributes are listed in the same order whatever the join produced
+void SaveRecordsToFile(HeapFile* file, int recLen, const char* resultFileNameString)
+{
+	Status status = OK;
+	Scan* scan = file->OpenScan(status);
+	if (status != OK)
+	{
+		cerr << "Cannot open scan on result HeapFile." << endl;
+		return;
+	}
+
+	FILE* f = fopen(resultFileNameString, "w");
+	if (f == NULL)
+	{
+		cerr << "Cannot open file " << resultFileNameString << " for writing.\n";
+		delete scan;
+		return;
+	}
+
+	int numOfAttr = recLen / sizeof(int);
+	int numOfRecords = file->GetNumOfRecords();
+	int* recs = new int[(numOfRecords + 1) * numOfAttr];
+	int len = recLen;
+	RecordID rid;
+
+	int n = 0;
+	while (n < numOfRecords && scan->GetNext(rid, (char *)(recs + n*numOfAttr), len) != DONE)
+	{
+		n++;
+	}
+
+	numOfComparedAttr = numOfAttr;
+	qsort(recs, n, recLen, CompareRecords);
+
+	for (int r = 0; r < n; r++)
+	{
+		for (int i = 0; i < numOfAttr; i++)
+		{
+			fprintf(f, (i + 1 < numOfAttr) ? "%d " : "%d\n", recs[r*numOfAttr + i]);
+		}
+	}
+	fclose(f);
+
+	delete[] recs;
+	delete scan;
+}
+
+
+// Create a relation of StringKeyed records holding the id (first
+// attribute) of every record of a relation and its attribute keyAttr
+// as a string
+void CreateStringKeyedRelation(JoinSpec spec, int keyAttr, const char* relName, JoinSpec& stringSpec)
+{
+	Status status = OK;
+
+	stringSpec = spec;
+	strcpy(stringSpec.relName, relName);
+	stringSpec.file = new HeapFile(NULL, status);
+	stringSpec.numOfAttr = 2;
+	stringSpec.recLen = sizeof(StringKeyed);
+	stringSpec.joinAttr = 1;
+	stringSpec.offset = sizeof(int);
+	stringSpec.keyType = KEY_STRING;
+	stringSpec.keyLen = STRING_KEY_LEN;
+	stringSpec.indexName[0] = '\0';
+	stringSpec.numOfOutAttr = ALL_ATTR;
+
+	Scan* scan = spec.file->OpenScan(status);
+	if (status != OK)
+	{
+		cerr << "Cannot open scan on relation " << spec.relName << "." << endl;
+		return;
+	}
+
+	int* rec = new int[spec.recLen / sizeof(int)];
+	int len = spec.recLen;
+	RecordID rid, stringRid;
+
+	while (scan->GetNext(rid, (char *)rec, len) == OK)
+	{
+		StringKeyed stringKeyed;
+		char key[16];
+
+		memset(&stringKeyed, 0, sizeof(StringKeyed));
+		stringKeyed.id = rec[0];
+		sprintf(key, "k%d", rec[keyAttr]);
+		strncpy(stringKeyed.key, key, STRING_KEY_LEN);
+
+		stringSpec.file->InsertRecord((char *)&stringKeyed, sizeof(StringKeyed), stringRid);
+	}
+
+	delete[] rec;
+	delete scan;
+}
+
+
+// Run every join method with the given join type and compare the
+// results with those of the tuple nested loop join
+void TestJoinType(JoinSpec specOfR, JoinSpec specOfS, JoinType joinType, const char* joinTypeName)
+{
+	specOfR.joinType = joinType;
+
+	int B = (MINIBASE_BM->GetNumOfUnpinnedBuffers() - 3 * 3) * MINIBASE_PAGESIZE;
+	int recLen = JoinedRecLen(specOfR, specOfS);
+
+	const char* methodNames[] = { "Tuple", "Block", "BlockHash", "Index", "IndexBatched", "Hash", "SortMerge", "CostBased", "BlockPinned" };
+	const int numOfMethods = sizeof(methodNames) / sizeof(methodNames[0]);
+
+	char fileNames[numOfMethods][64];
+	int firstDifferent = -1;
+
+	for (int method = 0; method < numOfMethods; method++)
+	{
+		HeapFile* joinedFile = NULL;
+		switch (method)
+		{
+			case 0: joinedFile = TupleNestedLoopJoin(specOfR, specOfS); break;
+			case 1: joinedFile = BlockNestedLoopJoin(specOfR, specOfS, B); break;
+			case 2: joinedFile = BlockNestedLoopJoin(specOfR, specOfS, B, PROBE_HASH); break;
+			case 3: joinedFile = IndexNestedLoopJoin(specOfR, specOfS); break;
+			case 4: joinedFile = IndexNestedLoopJoin(specOfR, specOfS, B); break;
+			case 5: joinedFile = HashJoin(specOfR, specOfS); break;
+			case 6: joinedFile = SortMergeJoin(specOfR, specOfS); break;
+			case 7: joinedFile = Join(specOfR, specOfS); break;
+			case 8: joinedFile = BlockNestedLoopJoin(specOfR, specOfS, B, PROBE_HASH, BLOCK_PINNED); break;
+		}
+
+		sprintf(fileNames[method], "%s%s", joinTypeName, methodNames[method]);
+		if (CheckJoinResult(joinedFile, methodNames[method], fileNames[method]))
+		{
+			SaveRecordsToFile(joinedFile, recLen, fileNames[method]);
+			joinedFile->DeleteFile();
+		}
+
+		if (method > 0 && firstDifferent == -1 && AreFilesEqual(fileNames[0], fileNames[method]))
+		{
+			firstDifferent = method;
+		}
+	}
+
+	if (-1 == firstDifferent)
+	{
+		cout << "PASS: all join methods yield equivalent " << joinTypeName << " join results.\n";
+	}
+	else
+	{
+		cerr << "FAIL: join methods DO NOT yield equivalent " << joinTypeName << " join results (see files " << fileNames[0] << ", " << fileNames[firstDifferent] << ").\n";
+	}
+}
+
+
 void PrintVerboseInfo(JoinSpec specOfR, JoinSpec specOfS, HeapFile* joinedFile)
 {
 	// Joined relation file name
@@ -128,25 +748,8 @@ void PrintVerboseInfo(JoinSpec specOfR, JoinSpec specOfS, HeapFile* joinedFile)
 
 int CountJoinedRecords(HeapFile* file)
 {
-	Status status = OK;
-	Scan *scan = file->OpenScan(status);
-	if (status != OK)
-	{
-		cerr << "Cannot open scan on result HeapFile." << endl;
-	}
-
-	EmployeeProject e;
-	int len;
-	RecordID rid;
-
-	int recordCount = 0;
-	while (scan->GetNext(rid, (char *)&e, len) != DONE)
-	{
-		recordCount++;
-	}
-
-	delete scan;
-	return recordCount;
+	HeapScanOperator scan(file, sizeof(EmployeeProject));
+	return CountRecords(&scan);
 }
 
 
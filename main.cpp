@@ -4,7 +4,9 @@
 
 #include "include/minirel.h"
 #include "include/bufmgr.h"
+#include "include/backgroundwriter.h"
 #include "include/heapfile.h"
+#include "include/heappagescan.h"
 #include "include/join.h"
 #include "include/relation.h"
 
@@ -16,29 +18,35 @@
 // Minibase definitions
 int MINIBASE_RESTART_FLAG = 0; // Used in Minibase part
 #define NUM_OF_DB_PAGES  2000  // # of DB pages
+#define READ_AHEAD_DEPTH    4  // # of pages scans read ahead (0 = off)
+#define BACKGROUND_WRITER_INTERVAL 10  // ms between background writer rounds (0 = off)
+
+// Buffer manager configurations every replacement policy is measured
+// under. Prefetched pages and clean-ahead rounds change the reference
+// stream a policy sees, so the miss ratios of the policies are only
+// comparable within one configuration.
+struct BufferConfiguration
+{
+	const char* name;
+	int readAheadDepth;
+	int backgroundWriterInterval;
+};
 
 // Performance analyser definitions
 #define RUN_TESTS           1  // Test mode ON/OFF
 #define REPETITION_COUNT    5  // Number of repetitions for each algorithm
 
 #if RUN_TESTS
+#include "include/bufmgrtest.h"
 #include "include/jointest.h"
 #endif
 // ----------------------------------------------------------------------------
 
 
-// ----------------------------------- ENUMS ----------------------------------
-enum JoinAlgorithm
-{
-	TUPLE_NESTED_LOOP,
-	BLOCK_NESTED_LOOP,
-	INDEX_NESTED_LOOP
-};
-// ----------------------------------------------------------------------------
-
-
 // ------------------------------- DECLARATIONS -------------------------------
 void AnalysePerformance(JoinAlgorithm algorithmType,
+						const char* replacementPolicy,
+						BufferConfiguration configuration,
 						int numOfBufPages,
 						int numOfRecInR,
 						int numOfRecInS,
@@ -52,15 +60,23 @@ void AnalysePerformance(JoinAlgorithm algorithmType,
 int main()
 {
 #if RUN_TESTS
+	RunBufMgrTests();
 	return RunTests();
 #endif
 
 	// Initialise random seed
 	srand(1);
 
-	JoinAlgorithm joinAlgorithms[] = { TUPLE_NESTED_LOOP, BLOCK_NESTED_LOOP, INDEX_NESTED_LOOP };
+	JoinAlgorithm joinAlgorithms[] = { TUPLE_NESTED_LOOP, BLOCK_NESTED_LOOP, INDEX_NESTED_LOOP, HASH, SORT_MERGE, COST_BASED };
+	const int numOfAlgorithms = sizeof(joinAlgorithms) / sizeof(joinAlgorithms[0]);
+
+	const char* replacementPolicies[] = { "Clock", "LRU-K", "2Q", "ARC" };
+	const int numOfPolicies = sizeof(replacementPolicies) / sizeof(replacementPolicies[0]);
+
+	BufferConfiguration configurations[] = { { "demand paging", 0, 0 }, { "read-ahead and background writer", READ_AHEAD_DEPTH, BACKGROUND_WRITER_INTERVAL } };
+	const int numOfConfigurations = sizeof(configurations) / sizeof(configurations[0]);
 
-	for (int algorithmIndex = 0; algorithmIndex < 3; algorithmIndex++)
+	for (int algorithmIndex = 0; algorithmIndex < numOfAlgorithms; algorithmIndex++)
 	//int algorithmIndex = 1;
 	{
 		JoinAlgorithm joinAlgorithm = joinAlgorithms[algorithmIndex];
@@ -78,21 +94,35 @@ int main()
 					cout << "Number of records in R:\t" << numberOfRecordsInR << "\n";
 					cout << "Number of records in S:\t" << numberOfRecordsInS << "\n";
 
-					double avgElapsedTime = 0.0, avgPinCount = 0.0, avgMissCount = 0.0;
-					for (int repetition = 0; repetition < REPETITION_COUNT; repetition++)
+					for (int configurationIndex = 0; configurationIndex < numOfConfigurations; configurationIndex++)
 					{
-						double elapsedTime;
-						long pinCount, missCount;
+						BufferConfiguration configuration = configurations[configurationIndex];
+						cout << "Buffer configuration:\t" << configuration.name << "\n";
 
-						AnalysePerformance(joinAlgorithm, bufferPoolSize, numberOfRecordsInR, numberOfRecordsInS, elapsedTime, pinCount, missCount);
+						for (int policyIndex = 0; policyIndex < numOfPolicies; policyIndex++)
+						{
+							const char* replacementPolicy = replacementPolicies[policyIndex];
+							cout << "Replacement policy:\t" << replacementPolicy << "\n";
 
-						avgElapsedTime += elapsedTime / (double)REPETITION_COUNT;
-						avgPinCount += (double)pinCount / (double)REPETITION_COUNT;
-						avgMissCount += (double)missCount / (double)REPETITION_COUNT;
+							double avgElapsedTime = 0.0, avgPinCount = 0.0, avgMissCount = 0.0;
+							for (int repetition = 0; repetition < REPETITION_COUNT; repetition++)
+							{
+								double elapsedTime;
+								long pinCount, missCount;
 
-					cout << "Average elapsed time:\t" << avgElapsedTime << "\n";
-					cout << "Average miss/pin count:\t" << avgMissCount << "\t" << avgPinCount << "\n\n";
+								AnalysePerformance(joinAlgorithm, replacementPolicy, configuration, bufferPoolSize, numberOfRecordsInR, numberOfRecordsInS, elapsedTime, pinCount, missCount);
+
+								avgElapsedTime += elapsedTime / (double)REPETITION_COUNT;
+								avgPinCount += (double)pinCount / (double)REPETITION_COUNT;
+								avgMissCount += (double)missCount / (double)REPETITION_COUNT;
+
+							cout << "Average elapsed time:\t" << avgElapsedTime << "\n";
+							cout << "Average miss/pin count:\t" << avgMissCount << "\t" << avgPinCount << "\n\n";
 					
+							}
+
+							cout << "Miss ratio:\t" << ((avgPinCount > 0) ? avgMissCount / avgPinCount : 0.0) << "\n\n";
+						}
 					}
 				}
 			}
@@ -104,6 +134,8 @@ int main()
 
 //
 // Input:  algorithmType - join algorithm type,
+//         replacementPolicy - buffer replacement policy,
+//         configuration - read-ahead and background writer settings,
 //         numOfBufPages - number of buffer pages,
 //         numOfRecInR   - number of records for relation R,
 //         numOfRecInS   - number of records for relation S.
@@ -113,6 +145,8 @@ int main()
 //         missCount     - number of misses when pinning the pages
 //
 void AnalysePerformance(JoinAlgorithm algorithmType,
+						const char* replacementPolicy,
+						BufferConfiguration configuration,
 						int numOfBufPages,
 						int numOfRecInR,
 						int numOfRecInS,
@@ -126,6 +160,15 @@ void AnalysePerformance(JoinAlgorithm algorithmType,
 		case TUPLE_NESTED_LOOP: joinAlgorithm = &TupleNestedLoopJoin; break;
 		case BLOCK_NESTED_LOOP: joinAlgorithm = &BlockNestedLoopJoin; break;
 		case INDEX_NESTED_LOOP: joinAlgorithm = &IndexNestedLoopJoin; break;
+		case HASH:              joinAlgorithm = &HashJoin; break;
+		case SORT_MERGE:        joinAlgorithm = &SortMergeJoin; break;
+		case COST_BASED:        joinAlgorithm = &Join; break;
+		default:
+			cerr << "ERROR: unknown join algorithm " << algorithmType << ".\n";
+			elapsedTime = 0;
+			pinCount = 0;
+			missCount = 0;
+			return;
 	}
 
 	// Remove MINIBASE.DB if it exists
@@ -142,6 +185,19 @@ void AnalysePerformance(JoinAlgorithm algorithmType,
 		numOfBufPages,  // Number of frames in buffer pool
 		NULL);
 
+	// The BufMgr constructor takes no policy, so it is chosen here
+	MINIBASE_BM->SetReplacementPolicy(replacementPolicy);
+
+	HeapPageScan::SetReadAheadDepth(configuration.readAheadDepth);
+
+	// Cleans dirty pages ahead of the replacer, so that the join seldom
+	// waits for a write when it needs a frame
+	BackgroundWriter* writer = NULL;
+	if (configuration.backgroundWriterInterval > 0)
+	{
+		writer = new BackgroundWriter(configuration.backgroundWriterInterval);
+	}
+
 	// Create Random Relations R(outer relation) and S for joining. The definition is in relation.h/
 	CreateR(numOfRecInR, numOfRecInS);
 	CreateS(numOfRecInR, numOfRecInS);
@@ -170,6 +226,7 @@ void AnalysePerformance(JoinAlgorithm algorithmType,
 	MINIBASE_BM->GetStat(pinCount, missCount);
 //	cout << elapsedTime << "\n";
 //	cout << missCount << "/" << pinCount << "\n";
+	delete writer;
 	delete minibase_globals;
 }
 // ----------------------------------------------------------------------------